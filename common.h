@@ -193,11 +193,14 @@ struct jdata { // per-feasible-dictionary-entry information relating to words wi
   unsigned char poscnt[MAXICC+1]; // number of positions where each unforced letter can go
   };
 
-struct sdata { // per-feasible-dictionary-entry information relating to words with spread entry mode
-  ABM flbm[MXFL]; // feasible letter bitmaps // could economise on storage here as done for jdata, but spreading only used with one-word dictionaries for now
-  double ct[MXFL][MXFL]; // [i][j] is the number of ways char i in string goes through entry slot j in word // must economise on storage if normal dictionaries are ever used
-  double ctd[MXFL]; // [j] is number of ways '-' goes through entry slot j in word
-  };
+// Per-feasible-dictionary-entry information relating to words with spread entry mode is stored in sdata
+// as one record of SDSZ(w) bytes for each entry in the feasible list, sized for the word's nent=m and wlen=n:
+//   ABM flbm[m];           feasible letter bitmaps
+//   double ct[n][m];       [i][j] is the number of ways char i in string goes through entry slot j in word
+//   double ctd[m];         [j] is number of ways '-' goes through entry slot j in word
+#define SDSZ(w) ((size_t)(w)->nent*(sizeof(ABM)+((w)->wlen+1)*sizeof(double)))
+#define SDFLBM(w,k) ((ABM*)((w)->sdata+(size_t)(k)*SDSZ(w)))
+#define SDCT(w,k) ((double*)(SDFLBM(w,k)+(w)->nent))
 
 struct word {
   int nent; // number of entries in word, <=MXFL
@@ -205,11 +208,20 @@ struct word {
   int jlen; // number of entries subject to jumble (<nent if tagged)
   int gx0,gy0; // start position (not necessarily mergerep)
   int ldir;
-  int*flist; // start of feasible list
+  int*flist; // start of feasible list; lights removed during the fill are kept after its end
   int flistlen; // length of feasible list
+  int*flist0; // copy of initial feasible list, held with bsi: bit i of the bitsets below refers to flist0[i]
+  int flistlen0; // length of initial feasible list
+  uint64_t*fbs; // bitset over flist0 of current feasible list, or 0 if not narrowing using bitset index
+  uint64_t**bsi; // bitset index: [k*(MAXICC+1)+c] is bitset of lights in flist0 with char c at position k, or 0 if none
+  double*fsc; // normal case: score of each light in feasible list, permuted along with flist; the allocation also holds fcol
+  unsigned char*fcol; // normal case: characters of lights in feasible list by column: fcol[k*fcs+j] is character k of flist[j]
+  int fcs; // column stride of fcol
+  double*fsc0; // copies of fsc and fcol in flist0 order (column stride flistlen0), held with bsi
+  unsigned char*fcol0;
   struct jdata*jdata;
   ABM*jflbm;
-  struct sdata*sdata;
+  char*sdata;
   int commitdep; // depth at which this word committed during fill, or -1 if not committed
   struct entry*e[MXFL]; // list of nent entries making up this word
   struct lprop*lp; // applicable properties for this word
@@ -301,6 +313,9 @@ extern volatile int abort_flag; // abort word list building?
 
 extern struct answer**ansp;
 extern struct light*lts;
+extern int*alenx;               // answer indices grouped by untreated length
+extern int alenst[MXLE+2];      // start of each length's group in alenx[]
+extern unsigned int alendm[MXLE+1]; // union of dictionary masks of each length's group
 
 extern int atotal;              // total answers in dict
 extern int ultotal;             // total unique lights in dict
@@ -334,7 +349,7 @@ extern int lightdir;
 // PREFERENCES
 
 #define NLOOKUP 6
-#define NPREFS (14+NLOOKUP*2)
+#define NPREFS (17+NLOOKUP*2)
 extern int prefdata[NPREFS];
 extern char prefstring[NPREFS][SLEN+1];
 #define clickblock (prefdata[0])
@@ -353,5 +368,8 @@ extern char prefstring[NPREFS][SLEN+1];
 #define startup_ff1 (prefstring[10+NLOOKUP*2+1])
 #define startup_af1 (prefstring[10+NLOOKUP*2+2])
 #define startup_al (prefdata[10+NLOOKUP*2+3])
+#define afrestart (prefdata[10+NLOOKUP*2+4])
+#define afrweights (prefdata[10+NLOOKUP*2+5])
+#define afbest (prefdata[10+NLOOKUP*2+6])
 
 #endif
@@ -137,7 +137,7 @@ static int newword() {
   }
 
 static int readblock(int depth,int dmask,int emask,int ten) {
-  char*tok;
+  char*tok,*te;
   int d,e,i,rc,u,w;
 #define FIRSTTOK tok=strtok(dbuf,DELIMS)
 #define NEXTTOK tok=strtok(0,DELIMS)
@@ -225,6 +225,63 @@ static int readblock(int depth,int dmask,int emask,int ten) {
       afrandom=*tok-'0';
       continue;
       }
+    if(!cmdcmp(tok,"RESTART","RS")) {
+      CHECKSTART("Restart directive")
+      NEXTTOK;
+      if(!tok||strlen(tok)!=1||*tok<'0'||*tok>'2') {batcherr("Syntax error in restart directive"); return 16;}
+      afrestart=*tok-'0';
+      NEXTTOK;
+      if(tok) {
+        if(!isdigit((unsigned char)*tok)) {batcherr("Syntax error in restart directive"); return 16;}
+        u=atoi(tok);
+        if(u<1||u>1000000) {batcherr("Restart interval must be 1..1000000"); return 16;}
+        filler_runit=u;
+        NEXTTOK;
+        if(tok) {
+          if(strlen(tok)!=1||*tok<'0'||*tok>'1') {batcherr("Syntax error in restart directive"); return 16;}
+          afrweights=*tok-'0';
+          }
+        }
+      continue;
+      }
+    if(!cmdcmp(tok,"BESTFILL","BF")) {
+      CHECKSTART("Best fill directive")
+      NEXTTOK;
+      if(!tok||!isdigit((unsigned char)*tok)) {batcherr("Syntax error in best fill directive"); return 16;}
+      u=atoi(tok);
+      if(u<0||u>3600) {batcherr("Best fill time limit must be 0..3600 seconds"); return 16;}
+      afbest=u;
+      continue;
+      }
+    if(!cmdcmp(tok,"ENUMERATE","EN")) {
+      CHECKSTART("Enumerate directive")
+      NEXTTOK;
+      if(!tok||strlen(tok)!=1||*tok<'0'||*tok>'2') {batcherr("Syntax error in enumerate directive"); return 16;}
+      filler_enum=*tok-'0';
+      filler_enumlim=0;
+      NEXTTOK;
+      if(tok) {
+        if(!isdigit((unsigned char)*tok)) {batcherr("Syntax error in enumerate directive"); return 16;}
+        filler_enumlim=strtoul(tok,0,10);
+        }
+      continue;
+      }
+    if(!cmdcmp(tok,"TIMELIMIT","TL")) {
+      CHECKSTART("Time limit directive")
+      NEXTTOK;
+      if(!tok||!isdigit((unsigned char)*tok)) {batcherr("Syntax error in time limit directive"); return 16;}
+      filler_tlimit=strtod(tok,&te);
+      if(*te) {batcherr("Syntax error in time limit directive"); return 16;}
+      continue;
+      }
+    if(!cmdcmp(tok,"NODELIMIT","NL")) {
+      CHECKSTART("Decision limit directive")
+      NEXTTOK;
+      if(!tok||!isdigit((unsigned char)*tok)) {batcherr("Syntax error in decision limit directive"); return 16;}
+      filler_nlimit=strtoul(tok,&te,10);
+      if(*te) {batcherr("Syntax error in decision limit directive"); return 16;}
+      continue;
+      }
     if(!cmdcmp(tok,"UNIQUE","UN")) {
       CHECKSTART("Unique fill directive")
       NEXTTOK;
@@ -232,6 +289,50 @@ static int readblock(int depth,int dmask,int emask,int ten) {
       afunique=*tok-'0';
       continue;
       }
+    if(!cmdcmp(tok,"FILLERBACKEND","FB")) {
+      CHECKSTART("Filler backend directive")
+      NEXTTOK;
+      if(!tok||strlen(tok)!=1||*tok<'0'||*tok>'1') {batcherr("Syntax error in filler backend directive"); return 16;}
+      filler_backend=*tok-'0';
+      continue;
+      }
+    if(!cmdcmp(tok,"BACKJUMP","BJ")) {
+      CHECKSTART("Backjump directive")
+      NEXTTOK;
+      if(!tok||strlen(tok)!=1||*tok<'0'||*tok>'2') {batcherr("Syntax error in backjump directive"); return 16;}
+      filler_cbj=*tok-'0';
+      continue;
+      }
+    if(!cmdcmp(tok,"THREADS","TH")) {
+      CHECKSTART("Threads directive")
+      NEXTTOK;
+      if(!tok||!isdigit((unsigned char)*tok)) {batcherr("Syntax error in threads directive"); return 16;}
+      u=atoi(tok);
+      if(u<1||u>64) {batcherr("Number of threads must be 1..64"); return 16;}
+      filler_threads=u;
+      continue;
+      }
+    if(!cmdcmp(tok,"PORTFOLIO","PO")) {
+      CHECKSTART("Portfolio directive")
+      NEXTTOK;
+      if(!tok||!isdigit((unsigned char)*tok)) {batcherr("Syntax error in portfolio directive"); return 16;}
+      u=atoi(tok);
+      if(u<1||u>64) {batcherr("Portfolio size must be 1..64"); return 16;}
+      filler_portfolio=u;
+      NEXTTOK;
+      if(tok) {
+        if(strlen(tok)!=1||*tok<'0'||*tok>'1') {batcherr("Syntax error in portfolio directive"); return 16;}
+        filler_pfheur=*tok-'0';
+        }
+      continue;
+      }
+    if(!cmdcmp(tok,"HEURISTIC","HE")) {
+      CHECKSTART("Heuristic directive")
+      NEXTTOK;
+      if(!tok||strlen(tok)!=1||*tok<'0'||*tok>'1') {batcherr("Syntax error in heuristic directive"); return 16;}
+      filler_heur=*tok-'0';
+      continue;
+      }
     if(!cmdcmp(tok,"TREATMENT","TR")) {
       CHECKSTART("Treatment directive")
       NEXTTOK;
@@ -419,10 +520,41 @@ int loaddeck(int cldict) {
   return rc;
   }
 
-int dumpdeck() {
-  int h,e,w,k;
+// print the words ws[] and their feasible lists, using the hints or, if h==0, the feasible letter bitmaps
+static void dumpwords(struct word*ws,int h) {
+  int e,w,k;
   char t0[MXFL*10+100];
 
+  for(w=0;w<nw0;w++) {
+    printf("W%d ",w);
+    for(e=0;e<ws[w].jlen;e++) if(dkwords[w].entries[e]<ne0) pabm(h?ws[w].e[e]->flbmh:ws[w].e[e]->flbm,1);
+    if(ws[w].flistlen) {
+      printf("\n# ");
+      for(k=0;k<ws[w].flistlen;k++) {
+        if(k>0) printf("; ");
+        ansform(t0,sizeof(t0),ws[w].flist[k],ws[w].wlen,ws[w].lp->dmask);
+        printf("%s",t0);
+        }
+      }
+    printf("\n");
+    }
+  for(;w<nw;w++) {
+    printf("M%d ",w-nw0);
+    for(e=0;e<ws[w].nent;e++) pabm(h?ws[w].e[e]->flbmh:ws[w].e[e]->flbm,1);
+    printf("\n");
+    }
+  }
+
+// called by the filler with the words of the n'th fill found while counting fills
+void dumpsol(struct word*ws,unsigned long n) {
+  printf("S%lu\n",n);
+  dumpwords(ws,0);
+  fflush(stdout);
+  }
+
+int dumpdeck() {
+  int h,e,w,rc=0;
+
   DEB_DE {
     printf("dumpdeck(): dkne=%d dknw=%d\n",dkne,dknw);
     for(h=0;h<ENHTABSZ;h++) if(enhtab[h]>=0) printf("H%4d>%4d\n",h,enhtab[h]);
@@ -445,6 +577,20 @@ int dumpdeck() {
     fprintf(stderr,"No fill found\n");
     return 4;
     }
+  if(filler_status==-6) {
+    fprintf(stderr,"Stopped at %s limit\n",filler_limhit==1?"time":"decision");
+    rc=8;
+    }
+  if(filler_enum) {
+    fprintf(stderr,"%s%lu fill%s found\n",(rc||(filler_enumlim&&filler_nsol>=filler_enumlim))?"At least ":"",filler_nsol,filler_nsol==1?"":"s");
+    return rc;
+    }
+  if(rc) {
+    for(e=0,h=0;e<ne0;e++) if(onebit(entries[e].flbmh)) h++;
+    fprintf(stderr,"Partial fill with %d of %d entries determined\n",h,ne0);
+    }
+  else if(afbest) fprintf(stderr,"Best fill score %.2f%s\n",filler_bestsc,filler_bestopt?" (optimal)":filler_limhit==2?" (decision limit reached)":" (time limit reached)");
+  else if(filler_portfolio>1) fprintf(stderr,"Fill found with filler seed 0x%08x, heuristic %d (reproduce with -F)\n",filler_wseed,filler_wheur);
 
   for(e=0;e<ne;e++) entries[e].flbm=entries[e].flbmh; // "accept all the hints"
   if(filler_start(3)) { // re-run filler to get feasible word lists
@@ -457,24 +603,6 @@ int dumpdeck() {
     for(e=0;e<ne;e++) printf("E%3d flbmh=%016llx\n",e,entries[e].flbmh);
     }
 
-  for(w=0;w<nw0;w++) {
-    printf("W%d ",w);
-    for(e=0;e<words[w].jlen;e++) if(dkwords[w].entries[e]<ne0) pabm(words[w].e[e]->flbmh,1);
-    if(words[w].flistlen) {
-      printf("\n# ");
-      for(k=0;k<words[w].flistlen;k++) {
-        if(k>0) printf("; ");
-        ansform(t0,sizeof(t0),words[w].flist[k],words[w].wlen,words[w].lp->dmask);
-        printf("%s",t0);
-        }
-      }
-    printf("\n");
-    }
-  for(;w<nw;w++) {
-    printf("M%d ",w-nw0);
-    for(e=0;e<words[w].nent;e++) pabm(words[w].e[e]->flbmh,1);
-    printf("\n");
-    }
-
-  return 0;
+  dumpwords(words,1);
+  return rc;
   }
@@ -28,5 +28,6 @@ Fifth Floor, Boston, MA  02110-1301, USA.
 
 extern int loaddeck(int cldict);
 extern int dumpdeck();
+extern void dumpsol(struct word*ws,unsigned long n);
 
 #endif
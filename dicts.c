@@ -31,7 +31,17 @@ Fifth Floor, Boston, MA  02110-1301, USA.
 #include "qxw.h"
 #include "gui.h"
 #include "dicts.h"
+#include "treatment.h"
 #include "alphabets.h"
+#include "filler.h"
+
+#ifndef _WIN32
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
 
 // default dictionaries
 #ifdef _WIN32
@@ -384,6 +394,9 @@ static struct memblk*dstrings[MAXNDICTS]={0}; // dictionary string pools
 
 struct answer*ans=0,**ansp=0;
 struct light*lts=0;
+int*alenx=0;                 // answer indices grouped by untreated length, ascending within each length
+int alenst[MXLE+2]={0};      // answers of untreated length l are alenx[alenst[l]..alenst[l+1]-1]
+unsigned int alendm[MXLE+1]; // union of the dictionary masks of the answers of each untreated length
 
 int atotal=0;                // total answers
 int ltotal=0;                // total lights
@@ -396,7 +409,6 @@ char dafilters[MAXNDICTS][SLEN];
 char lemdesc[NLEM][LEMDESCLEN]={""," (rev.)"," (cyc.)"," (cyc., rev.)","*"};
 char*lemdescADVP[NLEM]={"normally","reversed","cyclically permuted","cyclically permuted and reversed","with any other permutation"};
 
-static int line;
 int dst_lines[MAXNDICTS];
 int dst_lines_f[MAXNDICTS];
 int dst_lines_fa[MAXNDICTS];
@@ -404,7 +416,8 @@ int dst_u_rejline[MAXNDICTS][MAXUCHAR];
 int dst_u_rejline_count[MAXNDICTS][MAXUCHAR];
 
 #define HTABSZ 1048576
-static int ahtab[HTABSZ]={0};
+static int ahtab0[HTABSZ]={0};
+static int*ahtab=ahtab0; // answer hash table: ahtab0[], or in a mapped compiled dictionary file
 
 static int cmpans(const void*p,const void*q) {int u; // string comparison for qsort
   u=strcmp( (*(struct answer**)p)->ul,(*(struct answer**)q)->ul); if(u) return u;
@@ -413,7 +426,6 @@ static int cmpans(const void*p,const void*q) {int u; // string comparison for qs
 
 static void clearcounts(int dn) {
   int i;
-  line=0;
   dst_lines[dn]=0;
   dst_lines_f[dn]=0;
   dst_lines_fa[dn]=0;
@@ -426,12 +438,311 @@ static void freedstrings(int d) { // free string pool associated with dictionary
   while(dstrings[d]) {p=dstrings[d]->next;free(dstrings[d]);dstrings[d]=p;}
   }
 
+// COMPILED DICTIONARIES
+
+// Once a set of dictionaries has been loaded from text the result is written to a compiled file in the
+// user's .qxw directory: all the answers, with their strings, in the order loaddicts() leaves them after
+// sorting and removing duplicates, the ansp[] array, the answer hash table, the index of answers by
+// length and the per-dictionary statistics. The file is keyed by the names, sizes, modification times
+// and inodes of the dictionary files, the filters and a checksum of the alphabet mapping. When the same
+// set is loaded again the file is mapped into memory, checked to be self-consistent and used in place;
+// the only work done is to turn the offsets stored in the answer structures and ansp[] back into
+// pointers. If anything in the key has changed, or the file is damaged, the dictionaries are loaded from
+// text and a new file written. This is not done on Windows.
+
+static int dbok; // can the dictionaries being loaded be compiled?
+
+#ifdef _WIN32
+
+static void dbunmap(void) {}
+static char*dbnewkey(int*l) {return 0;}
+static int dbload(const char*k,int l) {return 1;}
+static void dbsave(int at,const char*k,int l) {}
+
+#else
+
+#define DBMAGIC "QXWDB001"
+#define DBRND(n) (((n)+7)&~(size_t)7) // keep sections aligned
+
+struct dbhdr { // header of compiled dictionary file, followed by the key
+  char magic[8];
+  int htabsz;                   // HTABSZ, sizeof(struct answer) and sizeof(void*) when written
+  int anssz;
+  int ptrsz;
+  int keyl;                     // length of key
+  int at;                       // number of answers, including duplicates
+  int atotal;                   // number of unique answers
+  int nrej;                     // number of rejected character records
+  unsigned int dusedmask;
+  size_t oans,oansp,oahtab,oalenx,orej,ostr,size; // offsets of sections, and size of file
+  int dst[3][MAXNDICTS];        // dst_lines[], dst_lines_f[] and dst_lines_fa[]
+  int alenst[MXLE+2];
+  unsigned int alendm[MXLE+1];
+  };
+
+struct dbrej { // record of a rejected Unicode character, as dst_u_rejline[] and dst_u_rejline_count[]
+  int dn,u,line,count;
+  };
+
+static char*dbmap=0; // mapped compiled file, or 0
+static size_t dbsize;
+
+static void dbunmap(void) {
+  if(!dbmap) return;
+  munmap(dbmap,dbsize);
+  dbmap=0;
+  ans=0;
+  ansp=0;
+  alenx=0;
+  ahtab=ahtab0;
+  }
+
+// FNV-1a checksum of n bytes at p
+static uint64_t dbsum(uint64_t h,const void*p,size_t n) {size_t i;
+  for(i=0;i<n;i++) h=(h^((const unsigned char*)p)[i])*0x100000001b3ULL;
+  return h;
+  }
+
+#ifdef __APPLE__
+  #define STMTIMENS(st) ((st).st_mtimespec.tv_nsec)
+#else
+  #define STMTIMENS(st) ((st).st_mtim.tv_nsec)
+#endif
+
+// build key describing the dictionaries to be loaded in k[], returning its length, or -1 if they cannot be compiled
+static int dbkey(char*k,int n) {
+  int dn,l;
+  uint64_t h;
+  struct stat st;
+
+  l=0;
+  for(dn=0;dn<MAXNDICTS;dn++) {
+    if(dfnames[dn][0]=='\0') memset(&st,0,sizeof(st));
+    else if(stat(dfnames[dn],&st)) return -1; // let loading from text report the error
+    l+=snprintf(k+l,n-l,"%d\t%s\t%lld\t%lld.%09ld\t%lld\t%s\t%s\n",dn,dfnames[dn],
+      (long long)st.st_size,(long long)st.st_mtime,(long)STMTIMENS(st),(long long)st.st_ino,dsfilters[dn],dafilters[dn]);
+    if(l>=n) return -1;
+    }
+  h=0xcbf29ce484222325ULL;
+  h=dbsum(h,uchartoicctab,sizeof(uchartoicctab));
+  h=dbsum(h,uchartopair,sizeof(uchartopair));
+  h=dbsum(h,pairtouchar,sizeof(pairtouchar));
+  h=dbsum(h,icctoutf8,sizeof(icctoutf8));
+  l+=snprintf(k+l,n-l,"%016llx\n",(unsigned long long)h);
+  if(l>=n) return -1;
+  return l;
+  }
+
+#define DBKEYSZ (MAXNDICTS*(SLEN*3+100)+100)
+
+// make the key for the dictionaries about to be loaded, setting *l to its length; returns 0 if they cannot be compiled
+static char*dbnewkey(int*l) {
+  char*k;
+
+  *l=0;
+  k=(char*)malloc(DBKEYSZ);
+  if(!k) return 0;
+  *l=dbkey(k,DBKEYSZ);
+  if(*l<0) {free(k); return 0;}
+  return k;
+  }
+
+// is offset o in the compiled file with header h the start of an answer?
+static int dbisans(struct dbhdr*h,size_t o) {
+  return o>=h->oans&&o<h->oans+(size_t)h->at*sizeof(struct answer)&&(o-h->oans)%sizeof(struct answer)==0;
+  }
+
+// is offset o in compiled file m with header h the start of a string of at most n bytes (not counting its terminator)?
+static int dbisstr(char*m,struct dbhdr*h,size_t o,size_t n) {
+  char*p;
+  if(o<h->ostr||o>=h->size) return 0;
+  p=memchr(m+o,0,h->size-o);
+  return p&&(size_t)(p-(m+o))<=n;
+  }
+
+// check that compiled file m, of size n, is self-consistent, before any offsets in it are used; returns !=0 if not
+static int dbcheck(char*m,size_t n) {
+  struct dbhdr*h;
+  struct answer*a;
+  struct dbrej*r;
+  size_t*o;
+  int i,*p;
+
+  h=(struct dbhdr*)m;
+  if(h->at<0||h->atotal<0||h->atotal>h->at||h->nrej<0) return 1;
+  if((h->oans|h->oansp|h->oahtab|h->oalenx|h->orej|h->ostr)&7) return 1; // sections are aligned
+  if(h->oans  <sizeof(struct dbhdr)+h->keyl||
+     h->oansp <h->oans  +(size_t)h->at    *sizeof(struct answer)||
+     h->oahtab<h->oansp +(size_t)h->atotal*sizeof(struct answer*)||
+     h->oalenx<h->oahtab+(size_t)HTABSZ   *sizeof(int)||
+     h->orej  <h->oalenx+(size_t)h->atotal*sizeof(int)||
+     h->ostr  <h->orej  +(size_t)h->nrej  *sizeof(struct dbrej)||
+     h->size  <h->ostr  ||h->size!=n) return 1; // sections in order and inside the file
+  a=(struct answer*)(m+h->oans);
+  for(i=0;i<h->at;i++) {
+    if(!dbisstr(m,h,(size_t)a[i].cf,SLEN)) return 1;
+    if(!dbisstr(m,h,(size_t)a[i].ul,MXLE)) return 1;
+    if(a[i].acf&&!dbisans(h,(size_t)a[i].acf)) return 1;
+    }
+  o=(size_t*)(m+h->oansp);
+  for(i=0;i<h->atotal;i++) {
+    if(!dbisans(h,o[i])) return 1;
+    if(((struct answer*)(m+o[i]))->ahlink<-1||((struct answer*)(m+o[i]))->ahlink>=h->atotal) return 1;
+    }
+  p=(int*)(m+h->oahtab);
+  for(i=0;i<HTABSZ;i++) if(p[i]<-1||p[i]>=h->atotal) return 1;
+  p=(int*)(m+h->oalenx);
+  for(i=0;i<h->atotal;i++) if(p[i]<0||p[i]>=h->atotal) return 1;
+  if(h->alenst[0]!=0||h->alenst[MXLE+1]!=h->atotal) return 1;
+  for(i=0;i<=MXLE;i++) if(h->alenst[i+1]<h->alenst[i]) return 1;
+  r=(struct dbrej*)(m+h->orej);
+  for(i=0;i<h->nrej;i++) if(r[i].dn<0||r[i].dn>=MAXNDICTS||r[i].u<0||r[i].u>=MAXUCHAR) return 1;
+  return 0;
+  }
+
+// load dictionaries from compiled file if there is one matching key k of length l; returns !=0 if not
+static int dbload(const char*k,int l) {
+  char s[SLEN],*m;
+  int dn,fd,i;
+  struct stat st;
+  struct dbhdr*h;
+  struct dbrej*r;
+  struct answer*a;
+
+  if(!k) return 1;
+  if(userpath(s,"dicts.bin",0)) return 1;
+  fd=open(s,O_RDONLY);
+  if(fd<0) return 1;
+  m=0;
+  if(!fstat(fd,&st)&&st.st_size>=(off_t)sizeof(struct dbhdr)) {
+    m=(char*)mmap(0,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0); // private so that answers can be banned
+    if(m==MAP_FAILED) m=0;
+    }
+  close(fd);
+  if(!m) return 1;
+  h=(struct dbhdr*)m;
+  if(memcmp(h->magic,DBMAGIC,8)||h->htabsz!=HTABSZ||h->anssz!=sizeof(struct answer)||h->ptrsz!=sizeof(void*)||
+     h->keyl<0||sizeof(struct dbhdr)+h->keyl>(size_t)st.st_size||h->keyl!=l||memcmp(m+sizeof(struct dbhdr),k,l)||
+     dbcheck(m,st.st_size)) {
+    DEB_DI printf("compiled dictionary file does not match\n");
+    munmap(m,st.st_size);
+    return 1;
+    }
+  dbmap=m;
+  dbsize=st.st_size;
+  ans=(struct answer*)(m+h->oans);
+  for(i=0;i<h->at;i++) { // turn offsets back into pointers
+    a=ans+i;
+    a->cf=m+(size_t)a->cf;
+    a->ul=m+(size_t)a->ul;
+    if(a->acf) a->acf=(struct answer*)(m+(size_t)a->acf);
+    }
+  ansp=(struct answer**)(m+h->oansp);
+  for(i=0;i<h->atotal;i++) ansp[i]=(struct answer*)(m+(size_t)ansp[i]);
+  ahtab=(int*)(m+h->oahtab);
+  alenx=(int*)(m+h->oalenx);
+  memcpy(alenst,h->alenst,sizeof(alenst));
+  memcpy(alendm,h->alendm,sizeof(alendm));
+  atotal=h->atotal;
+  dusedmask=h->dusedmask;
+  for(dn=0;dn<MAXNDICTS;dn++) {
+    clearcounts(dn);
+    dst_lines[dn]=h->dst[0][dn];
+    dst_lines_f[dn]=h->dst[1][dn];
+    dst_lines_fa[dn]=h->dst[2][dn];
+    }
+  r=(struct dbrej*)(m+h->orej);
+  for(i=0;i<h->nrej;i++) dst_u_rejline[r[i].dn][r[i].u]=r[i].line,dst_u_rejline_count[r[i].dn][r[i].u]=r[i].count;
+  DEB_DI printf("loaded %d answers from compiled dictionary file\n",atotal);
+  return 0;
+  }
+
+// write the dictionaries just loaded, with at answers in ans[], to a compiled file with key k of length l; failure is silent
+static void dbsave(int at,const char*k,int l) {
+  char s[SLEN],t[SLEN+20];
+  int dn,i,u;
+  size_t o;
+  FILE*fp;
+  struct dbhdr h;
+  struct dbrej r;
+  struct answer a;
+  static const char z[8]={0};
+
+  if(!k||!dbok) return;
+  if(userpath(s,"dicts.bin",1)) return;
+  memset(&h,0,sizeof(h));
+  h.keyl=l;
+  memcpy(h.magic,DBMAGIC,8);
+  h.htabsz=HTABSZ;
+  h.anssz=sizeof(struct answer);
+  h.ptrsz=sizeof(void*);
+  h.at=at;
+  h.atotal=atotal;
+  h.dusedmask=dusedmask;
+  for(dn=0;dn<MAXNDICTS;dn++) {
+    h.dst[0][dn]=dst_lines[dn];
+    h.dst[1][dn]=dst_lines_f[dn];
+    h.dst[2][dn]=dst_lines_fa[dn];
+    for(u=0;u<MAXUCHAR;u++) if(dst_u_rejline_count[dn][u]) h.nrej++;
+    }
+  memcpy(h.alenst,alenst,sizeof(alenst));
+  memcpy(h.alendm,alendm,sizeof(alendm));
+  h.oans  =DBRND(sizeof(h)+h.keyl);
+  h.oansp =h.oans  +DBRND(at*sizeof(struct answer));
+  h.oahtab=h.oansp +DBRND(atotal*sizeof(struct answer*));
+  h.oalenx=h.oahtab+DBRND(HTABSZ*sizeof(int));
+  h.orej  =h.oalenx+DBRND(atotal*sizeof(int));
+  h.ostr  =h.orej  +DBRND(h.nrej*sizeof(struct dbrej));
+  for(i=0,o=h.ostr;i<at;i++) o+=strlen(ans[i].cf)+1+strlen(ans[i].ul)+1;
+  h.size=o;
+  sprintf(t,"%s.%d",s,(int)getpid()); // write to a temporary file and rename it into place
+  fp=fopen(t,"wb");
+  if(!fp) return;
+  fwrite(&h,sizeof(h),1,fp);
+  fwrite(k,1,h.keyl,fp);
+  fwrite(z,1,h.oans-sizeof(h)-h.keyl,fp);
+  for(i=0,o=h.ostr;i<at;i++) { // answers with pointers replaced by offsets
+    a=ans[i];
+    a.cf=(char*)o; o+=strlen(ans[i].cf)+1;
+    a.ul=(char*)o; o+=strlen(ans[i].ul)+1;
+    if(a.acf) a.acf=(struct answer*)(h.oans+(a.acf-ans)*sizeof(struct answer));
+    fwrite(&a,sizeof(a),1,fp);
+    }
+  fwrite(z,1,h.oansp-h.oans-at*sizeof(struct answer),fp);
+  for(i=0;i<atotal;i++) {
+    o=h.oans+(ansp[i]-ans)*sizeof(struct answer);
+    fwrite(&o,sizeof(o),1,fp);
+    }
+  fwrite(z,1,h.oahtab-h.oansp-atotal*sizeof(struct answer*),fp);
+  fwrite(ahtab,sizeof(int),HTABSZ,fp);
+  fwrite(alenx,sizeof(int),atotal,fp);
+  fwrite(z,1,h.orej-h.oalenx-atotal*sizeof(int),fp);
+  for(dn=0;dn<MAXNDICTS;dn++) for(u=0;u<MAXUCHAR;u++) if(dst_u_rejline_count[dn][u]) {
+    r.dn=dn,r.u=u,r.line=dst_u_rejline[dn][u],r.count=dst_u_rejline_count[dn][u];
+    fwrite(&r,sizeof(r),1,fp);
+    }
+  fwrite(z,1,h.ostr-h.orej-h.nrej*sizeof(struct dbrej),fp);
+  for(i=0;i<at;i++) {
+    fwrite(ans[i].cf,1,strlen(ans[i].cf)+1,fp);
+    fwrite(ans[i].ul,1,strlen(ans[i].ul)+1,fp);
+    }
+  if(ferror(fp)|fclose(fp)) {remove(t); return;}
+  if(rename(t,s)) remove(t);
+  DEB_DI printf("wrote compiled dictionary file %s\n",s);
+  }
+
+#endif
+
 void freedicts(void) { // free all memory allocated by loaddicts, even if it aborted mid-load
   int i;
   for(i=0;i<MAXNDICTS;i++) freedstrings(i);
+  dbunmap();
   FREEX(ans);
   FREEX(ansp);
+  FREEX(alenx);
+  memset(alenst,0,sizeof(alenst));
   atotal=0;
+  invalflcache(); // cached feasible lists refer to the answers just freed
   }
 
 // answer pool is linked list of `struct memblk's containing
@@ -442,51 +753,81 @@ void freedicts(void) { // free all memory allocated by loaddicts, even if it abo
 //     (0-terminated) citation form, in UTF-8
 //     (0-terminated) untreated light form, in chars
 
-static struct memblk*memblkp=0;
-static int memblkl=0;
+// Text dictionaries are read in chunks, several at once: see READING DICTIONARIES IN PARALLEL below.
+// Each chunk has its own string pool and counts; these are gathered up in file order when all are read.
+struct dchunk {
+  int dn;                  // dictionary number
+  char*p,*e;               // text of chunk and its end
+  int line0,line;          // number of line before the first in the chunk, and of the current line
+  struct memblk*first,*last; // string pool
+  int l;                   // number of bytes used in last
+  int nw;                  // number of answers added
+  int nl,nlf,nlfa;         // number of lines read, passing file filter and passing answer filter
+  int rc;                  // 0, -2 for out of memory or -3 for bad encoding
+  };
+
+static struct dslot { // a dictionary being loaded
+  int mode;                // encoding: index into fenc[] or -1 for UTF-8, -2 for ISO-8859-1 when there is no BOM
+  pcre*sre,*are;           // file and answer filters
+  char*buf;                // text of file
+  int c0,c1;               // its chunks are dch[c0..c1-1]
+  } dsl[MAXNDICTS];
+
+static struct dchunk*dch=0; // chunks of all dictionaries being loaded
+static int ndch=0,mdch=0;   // number in use, number allocated
+
+// record rejected Unicode character u at line l of dictionary dn; calls may be made from several threads
+static void notereject(int dn,int u,int l) {int m;
+  g_atomic_int_inc(dst_u_rejline_count[dn]+u);
+  do {
+    m=g_atomic_int_get(dst_u_rejline[dn]+u);
+    if(m!=-1&&m<=l) return; // keep only the first instance of rejected Unicode
+    } while(!g_atomic_int_compare_and_exchange(dst_u_rejline[dn]+u,m,l));
+  }
 
-// Add a new dictionary word with UTF-8 citation form s0
-// dictionary number dn, score f. Return 1 if added, 0 if not, -2 for out of memory
-static int adddictword(char*s0,int dn,pcre*sre,pcre*are,float f) {
-  int c,c0,i,l0,l1,l2;
+// Add a new dictionary word with UTF-8 citation form s0 and score f
+// to the pool of chunk c. Return 1 if added, 0 if not, -2 for out of memory
+static int adddictword(struct dchunk*c,char*s0,float f) {
+  int c0,i,l0,l1,l2,u0;
   uchar t[MXLE+1],u;
   char s1[MXLE*16+1];
   char s2[MXLE+1];
   struct memblk*q;
+  pcre*sre,*are;
   int pcreov[120];
 
+  sre=dsl[c->dn].sre;
+  are=dsl[c->dn].are;
   l0=strlen(s0);
   utf8touchars(t,s0,MXLE+1);
   for(i=0,l1=0,l2=0;t[i];i++) {
     u=t[i];
     if(!ISUGRAPH(u)) continue; // printable, not a space?
     if(u>=MAXUCHAR) continue;
-    c=uchartoICC(u);
-    if(c) { // characters is in basic alphabet; could check for "reject" chars here
+    u0=uchartoICC(u);
+    if(u0) { // characters is in basic alphabet; could check for "reject" chars here
       if(l2>=MXLE) return 0; // too long?
-      strcpy(s1+l1,icctoutf8[c]); l1+=strlen(s1+l1);
-      s2[l2++]=c;
+      strcpy(s1+l1,icctoutf8[u0]); l1+=strlen(s1+l1);
+      s2[l2++]=u0;
       continue;
       }
     else {
-      c=uchartopair[t[i]];
-      if(c) { // represents a pair of characters?
-        c0=uchartoICC(pairtouchar[c][0]);
+      u0=uchartopair[t[i]];
+      if(u0) { // represents a pair of characters?
+        c0=uchartoICC(pairtouchar[u0][0]);
         if(c0) {
           if(l2>=MXLE) return 0; // too long?
           strcpy(s1+l1,icctoutf8[c0]); l1+=strlen(s1+l1);
           s2[l2++]=c0;
           }
-        c0=uchartoICC(pairtouchar[c][1]);
+        c0=uchartoICC(pairtouchar[u0][1]);
         if(c0) {
           if(l2>=MXLE) return 0; // too long?
           strcpy(s1+l1,icctoutf8[c0]); l1+=strlen(s1+l1);
           s2[l2++]=c0;
           }
         }
-      else {
-        if(dst_u_rejline_count[dn][u]++==0) dst_u_rejline[dn][u]=line; // record first instance of rejected Unicode
-        }
+      else notereject(c->dn,u,c->line);
       }
     }
   s1[l1]=0;
@@ -506,7 +847,7 @@ static int adddictword(char*s0,int dn,pcre*sre,pcre*are,float f) {
   //      s1 contains canonicalised form in UTF-8, length l1
   //      s2 contains canonicalised form in internal character code, length l2 1<=l2<=MXLE
 
-  dst_lines[dn]++;
+  c->nl++;
   if(sre) {
     i=pcre_exec(sre,0,s0,l0,0,0,pcreov,120);
     DEB_DI if(i<-1) printf("PCRE error %d\n",i);
@@ -515,7 +856,7 @@ static int adddictword(char*s0,int dn,pcre*sre,pcre*are,float f) {
       return 0; // failed match
       }
     }
-  dst_lines_f[dn]++;
+  c->nlf++;
   if(are) {
     i=pcre_exec(are,0,s1,l1,0,0,pcreov,120);
     DEB_DI if(i<-1) printf("PCRE error %d\n",i);
@@ -524,22 +865,23 @@ static int adddictword(char*s0,int dn,pcre*sre,pcre*are,float f) {
       return 0; // failed match
       }
     }
-  dst_lines_fa[dn]++;
+  c->nlfa++;
 
-  if(memblkp==NULL||memblkl+2+l0+1+l2+1>MEMBLK) { // allocate more memory if needed (this always happens on first pass round loop)
+  if(c->last==NULL||c->l+2+l0+1+l2+1>MEMBLK) { // allocate more memory if needed (this always happens on first pass round loop)
     q=(struct memblk*)malloc(sizeof(struct memblk));
     if(q==NULL) {return -2;}
     q->next=NULL;
-    if(memblkp==NULL) dstrings[dn]=q; else memblkp->next=q; // link into list
-    memblkp=q;
-    memblkp->ct=0;
-    memblkl=0;
-    }
-  *(memblkp->s+memblkl++)=(char)floor(f*10.0+128.5); // score with rounding
-  *(memblkp->s+memblkl++)=dn;
-  strcpy(memblkp->s+memblkl,s0);memblkl+=l0+1; // citation form, UTF-8
-  strcpy(memblkp->s+memblkl,s2);memblkl+=l2+1; // canonical form, internal character code
-  memblkp->ct++; // count words in this memblk
+    if(c->last==NULL) c->first=q; else c->last->next=q; // link into list
+    c->last=q;
+    c->last->ct=0;
+    c->l=0;
+    }
+  *(c->last->s+c->l++)=(char)floor(f*10.0+128.5); // score with rounding
+  *(c->last->s+c->l++)=c->dn;
+  strcpy(c->last->s+c->l,s0);c->l+=l0+1; // citation form, UTF-8
+  strcpy(c->last->s+c->l,s2);c->l+=l2+1; // canonical form, internal character code
+  c->last->ct++; // count words in this memblk
+  c->nw++;
   return 1;
   }
  
@@ -573,17 +915,40 @@ DEB_DI printf("addhcode(%d,%d,%d) nhn=%d\n",m,l,i,nhn);
   return 0;
   }
 
+// Words are decoded HBITS bits at a time: hdtab[] is indexed by the next HBITS bits of input, first bit
+// in bit 0, and gives the character decoded and hdlen[] the number of bits used. If the code is longer
+// than HBITS bits hdtab[] gives HDNODE plus the node reached instead; -1 means a bit sequence that is not a code.
+#define HBITS 12
+#define HDNODE 256
+static short hdtab[1<<HBITS];
+static unsigned char hdlen[1<<HBITS];
+
+static void mkhdtab(void) {int i,j,n;
+  for(i=0;i<1<<HBITS;i++) {
+    for(j=0,n=0;j<HBITS;) {
+      n=hnodep[(i>>j)&1][n];
+      j++;
+      if(n==-1||hnodec[n]!=-1) break;
+      }
+    hdlen[i]=j;
+    if(n==-1)              hdtab[i]=-1;
+    else if(hnodec[n]!=-1) hdtab[i]=hnodec[n];
+    else                   hdtab[i]=HDNODE+n;
+    }
+  }
+
 // Attempt to load a .TSD file. Return number of words >=0 on success, <0 on error.
-static int loadtsd(FILE*fp,int format,int dn,pcre*sre,pcre*are) {
-  int c,i,j,l,m,ml,n,u,nw;
+static int loadtsd(FILE*fp,int format,struct dchunk*ch) {
+  int c,i,j,k,l,m,ml,n,u,nw;
   int hoff[MXLE+1]; // file offsets into Huffman coded block
   int dcount[MXLE+1]; // number of words of each length
   char s1[SLEN];
-  GError*error=NULL;
-  gchar*sp=NULL;
+  char s0[SLEN*2]; // UTF-8 version of s1
+  unsigned char*b;
+  size_t nb,p;
 
   DEB_DI printf("attempting to load TSD format=0x%x\n",format);
-  clearcounts(dn);
+  clearcounts(ch->dn);
   if(format!='0'&&format!='1') return -1; // only TSD0 and TSD1 supported
   if(fseek(fp,4,SEEK_SET)<0) return -1;
   ml=getint(fp,2); // maximum length
@@ -625,221 +990,344 @@ DEB_DI {
       if(addhcode(m,l,i)<0) return -1;
       }
     }
+  // read the whole file into memory, with some zero bytes after it so that we can always look HBITS bits ahead
+  if(fseek(fp,0,SEEK_END)<0) return -1;
+  if(ftell(fp)<0) return -1;
+  nb=ftell(fp);
+  b=(unsigned char*)malloc(nb+3);
+  if(b==NULL) return -2;
+  rewind(fp);
+  if(fread(b,1,nb,fp)!=nb) {free(b); return -1;}
+  b[nb]=b[nb+1]=b[nb+2]=0;
+  nb*=8; // number of bits in file
+  mkhdtab();
   nw=0;
   for(l=1;l<ml;l++) {
     if(l>MXLE) break;
     if(hoff[l]==0) continue;
-    if(fseek(fp,hoff[l],SEEK_SET)<0) return -1;
-    DEB_DI printf("starting to read length %d at offset %08x; dstrings[%d]=%p memblkp=%p\n",l,hoff[l],dn,(void*)dstrings[dn],(void*)memblkp);
-    j=8;
-    c=0;
+    p=(size_t)hoff[l]*8; // bit position in file
+    DEB_DI printf("starting to read length %d at offset %08x; pool=%p\n",l,hoff[l],(void*)ch->last);
     for(i=0;i<dcount[l];i++) {
       m=0;
-      n=0;
-      for(;;) {
-        if(j==8) {j=0;c=fgetc(fp);if(c==EOF) return -1;}
-        DEB_DI printf("%d",(c>>j)&1);
-        n=hnodep[(c>>j)&1][n];
-        j++;
-        u=hnodec[n];
-        if(u!=-1) {
-          DEB_DI printf(" %02x %c\n",u,isprint(u)?u:'?');
-          if((u>=0x01&&u<0x7f)||(u>=0xa0&&u<=0xff)) {
-            s1[m]=u;
-            if(m<SLEN-1) m++; // don't overflow
-            }
-          n=0;
+      do {
+        if(p>=nb) goto ew0; // off end of file
+        k=((b[p>>3]|b[(p>>3)+1]<<8|b[(p>>3)+2]<<16)>>(p&7))&((1<<HBITS)-1);
+        u=hdtab[k];
+        p+=hdlen[k];
+        if(u>=HDNODE) { // long code: carry on a bit at a time
+          n=u-HDNODE;
+          do {
+            if(p>=nb) goto ew0;
+            n=hnodep[(b[p>>3]>>(p&7))&1][n];
+            p++;
+            } while(n!=-1&&hnodec[n]==-1);
+          u=n==-1?-1:hnodec[n];
           }
-        if(u==0) break;
-        }
-      if(format=='1') {
-        if(j==8) {j=0;c=fgetc(fp);if(c==EOF) return -1;} // skip a zero bit for some reason
-        j++;
+        if(u<0||p>nb) goto ew0; // not a code, or off end of file
+        DEB_DI printf(" %02x %c\n",u,isprint(u)?u:'?');
+        if((u>=0x01&&u<0x7f)||(u>=0xa0&&u<=0xff)) {
+          s1[m]=u;
+          if(m<SLEN-1) m++; // don't overflow
+          }
+        } while(u!=0);
+      if(format=='1') { // skip a zero bit for some reason
+        if(p>=nb) goto ew0;
+        p++;
         }
       if(m==SLEN-1) continue; // hit string limit? discard
       s1[m]=0;
       for(u=0;u<m;u++) if((unsigned char)s1[u]<0x20) break; // look for any non-printable character
-      s1[u]=0; // stop there
-      sp=g_convert(s1,-1,"UTF-8","ISO-8859-1",NULL,NULL,&error);
-      if(error) continue;
-      u=adddictword(sp,dn,sre,are,0.0);
-      g_free(sp),sp=0;
-      if(u==-2) return -2;
+      for(j=0,k=0;j<u;j++) { // convert from ISO-8859-1 to UTF-8, stopping at any non-printable character
+        c=(unsigned char)s1[j];
+        if(c<0x80) s0[k++]=c;
+        else       s0[k++]=0xc0|c>>6,s0[k++]=0x80|(c&0x3f);
+        }
+      s0[k]=0;
+      u=adddictword(ch,s0,0.0);
+      if(u==-2) {free(b); return -2;}
       if(u==1) nw++;
       }
     }
+  free(b);
   return nw;
+ew0:
+  free(b);
+  return -1;
   }
 
 
-// return number of answers loaded or:
-// -1: file not found or problem with encoding
-// -2: out of memory error from adddictword
-static int loadonedict(int dn,int sil) {
-  int at,i,j;
-  FILE *fp=0;
+// READING DICTIONARIES IN PARALLEL
+
+// The text of a dictionary file is read into memory in one go and cut at line ends into chunks of
+// about DCHUNK bytes. The chunks of all the dictionaries are then read concurrently using pforeach();
+// the chunks of each dictionary are finally spliced together in file order, so the answer pool and
+// counts are just as they would be if the file had been read a line at a time.
+
+#define DCHUNK 1048576
+
+// Read line t of a dictionary into chunk c using the encoding of the dictionary.
+// Return 0 if OK, -2 for out of memory or -3 if t is not in that encoding
+static int dictline(struct dchunk*c,gchar*t) {
+  int i,j,mode;
   char s0[SLEN]; // citation form
+  float f;
+  GError*error=NULL;
+  gchar*sp=NULL;
+  gsize l0;
+
+  mode=dsl[c->dn].mode;
+  j=strlen(t)-1;
+  if(j<0) return 0;
+  while(j>=0&&t[j]>=0&&t[j]<=' ') t[j--]=0;     // Strip control characters/white space from end of string
+  while (j>=0&&((t[j]>='0'&&t[j]<='9')||t[j]=='.'||t[j]=='+'||t[j]=='-')) j--;  // get score (if any) from end
+  j++;
+  f=0.0;
+  if(j==0||t[j-1]!=' ') j=strlen(t); // all digits, or no space? treat it as a 'word'
+  else {
+    sscanf(t+j,"%f",&f);
+    if(f>= 10.0) f= 10.0;
+    if(f<=-10.0) f=-10.0;
+    t[j--]=0; // rest of input is treated as a 'word' (which may contain spaces)
+    }
+  while(j>=0&&t[j]>=0&&t[j]<=' ') t[j--]=0;  // remove trailing white space
+  j++;
+  if(j<1) return 0;
+
+  // t now contains 'word' for conversion; convert it first to UTF-8 for use as citation form
+  if(mode>-1)  sp=g_convert(t,-1,"UTF-8",fenc[mode].nenc,NULL,&l0,&error); // Use encoding mode based on BOM
+  if(mode==-1) sp=g_convert(t,-1,"UTF-8","UTF-8",NULL,&l0,&error); // effectively a check for valid UTF-8
+  if(mode==-2) sp=g_convert(t,-1,"UTF-8","ISO-8859-1",NULL,&l0,&error);
+  if(error) {
+    DEB_DI {
+      printf("error: %s\n",error->message);
+      for(i=0;t[i];i++) printf(" %02x",t[i]);
+      printf("\n");
+      }
+    g_clear_error(&error);
+    if(sp) g_free(sp);
+    return -3;
+    }
+  // here we have UTF-8 citation form of string in sp, length in l0
+  if(l0>=SLEN) {g_free(sp); return 0;}
+  strcpy(s0,sp);
+  g_free(sp);
+  return adddictword(c,s0,f)==-2?-2:0;
+  }
+
+// read chunk i of the array at a, splitting it into lines as fgets(t,SLEN,...) would
+static void readchunk(int i,void*a) {
+  struct dchunk*c;
   gchar t[SLEN+1]; // input buffer
+  char*p;
+  int k;
+
+  c=(struct dchunk*)a+i;
+  for(p=c->p;p<c->e;) {
+    for(k=0;k<SLEN-1&&p<c->e;) if((t[k++]=*p++)=='\n') break;
+    t[k]=0;
+    c->line++;
+    c->rc=dictline(c,t);
+    if(c->rc<0) return;
+    }
+  }
 
-  float f;
-  int mode,owd,rc;
-  pcre*sre,*are;
+// add a chunk p..e of dictionary dn, starting after line l; return 0 or -2 for out of memory
+static int newchunk(int dn,char*p,char*e,int l) {
+  struct dchunk*c;
+
+  if(ndch>=mdch) {
+    c=(struct dchunk*)realloc(dch,(mdch+16)*sizeof(struct dchunk));
+    if(c==NULL) return -2;
+    dch=c;
+    mdch+=16;
+    }
+  c=dch+ndch++;
+  memset(c,0,sizeof(struct dchunk));
+  c->dn=dn;
+  c->p=p;
+  c->e=e;
+  c->line0=c->line=l;
+  dsl[dn].c1=ndch;
+  return 0;
+  }
+
+// free string pools of chunks i0..i1-1
+static void freechunks(int i0,int i1) {
+  struct memblk*p;
+  int i;
+
+  for(i=i0;i<i1;i++) {
+    while(dch[i].first) {p=dch[i].first->next;free(dch[i].first);dch[i].first=p;}
+    dch[i].last=0;
+    }
+  }
+
+// free everything used while loading dictionary dn
+static void freeslot(int dn) {
+  struct dslot*d;
+
+  d=dsl+dn;
+  freechunks(d->c0,d->c1);
+  if(d->sre) pcre_free(d->sre);
+  if(d->are) pcre_free(d->are);
+  FREEX(d->buf);
+  d->sre=0;
+  d->are=0;
+  d->c0=d->c1=0;
+  }
+
+// Set up to load dictionary dn: compile its filters and cut its text into chunks; one-word and .TSD
+// dictionaries are loaded here into a single chunk. Return 0 or:
+// -1: file not found or problem with encoding
+// -2: out of memory
+static int opendict(int dn,int sil) {
+  struct dslot*d;
+  FILE*fp;
+  gchar t[SLEN+1];
   const char*pcreerr;
   int pcreerroff;
-  char sfilter[SLEN+1];
-  char afilter[SLEN+1];
-  GError *error = NULL;
-  gchar *sp = NULL;
-  gsize l0;
   char bom[5];
-
-  rc=0;
-  owd=0;
-  at=0;
-  freedstrings(dn);
-  memblkl=0; // number of bytes stored so far in current memory block
-  memblkp=0; // current memblk being filled
+  char*p,*q,*r,*e;
+  long m,n;
+  int i,l,rc;
+
+  d=dsl+dn;
+  d->mode=-1;    // Indicates file encoding not set by BOM in file
+  d->sre=0;
+  d->are=0;
+  d->buf=0;
+  d->c0=d->c1=ndch;
+  clearcounts(dn);
   if(dfnames[dn][0]=='\0') {
     if(dafilters[dn][0]=='\0') return 0; // dictionary slot unused
-    owd=1; // one-word dictionary
-    sre=0;
-    are=0;
-    goto ew3;
+    // one-word dictionary
+    d->mode=1; // Always set file encoding to UTF-8 for one-word dictionary
+    if(newchunk(dn,0,0,0)) return -2;
+    strcpy(t,dafilters[dn]);
+    dch[d->c0].rc=dictline(dch+d->c0,t);
+    return 0;
     }
-  strcpy(sfilter,dsfilters[dn]);
-  if(!strcmp(sfilter,"")) sre=0;
-  else {
-    sre=pcre_compile(sfilter,PCRE_CASELESS|PCRE_UTF8|PCRE_UCP,&pcreerr,&pcreerroff,0);
+  if(strcmp(dsfilters[dn],"")) {
+    d->sre=pcre_compile(dsfilters[dn],PCRE_CASELESS|PCRE_UTF8|PCRE_UCP,&pcreerr,&pcreerroff,0);
     if(pcreerr) {
       sprintf(t,"Dictionary %d\nBad file filter syntax: %.100s",dn+1,pcreerr);
       if(!sil) reperr(t);
+      dbok=0; // don't compile: the error would not be reported next time
       }
     }
-  strcpy(afilter,dafilters[dn]);
-  if(!strcmp(afilter,"")) are=0;
-  else {
-    are=pcre_compile(afilter,PCRE_CASELESS|PCRE_UTF8|PCRE_UCP,&pcreerr,&pcreerroff,0);
+  if(strcmp(dafilters[dn],"")) {
+    d->are=pcre_compile(dafilters[dn],PCRE_CASELESS|PCRE_UTF8|PCRE_UCP,&pcreerr,&pcreerroff,0);
     if(pcreerr) {
       sprintf(t,"Dictionary %d\nBad answer filter syntax: %.100s",dn+1,pcreerr);
       if(!sil) reperr(t);
+      dbok=0; // don't compile: the error would not be reported next time
       }
     }
 
-ew3:
-  mode=-1;    // Indicates file encoding not set by BOM in file
-  if(owd) { mode=1; goto retry; }   // Always set file encoding to UTF-8 for one-word dictionary
   fp=q_fopen(dfnames[dn],"rb"); // binary mode
   if(!fp) {
     sprintf(t,"Dictionary %d\nFile not found",dn+1);
     if(!sil) reperr(t);
-    rc=-1; goto exit;
-    }
-  if(fread(bom,1,4,fp)<4) {rewind(fp); goto retry;} // too short for a BOM, so use mode -1
-  if(!strncmp(bom,"TSD",3)) {
-    i=loadtsd(fp,bom[3],dn,sre,are);
-    if(i>=0) {at=i; goto exit;} // successfully read
+    return -1;
     }
-  rewind(fp);
-  if(fgets(bom,5,fp)!=NULL) {       // re-read BOM at start of file
-    for(i=0; i<NFILEENC; i++) {
-      if(fenc[i].lbom>0) {
-        if(!(memcmp(bom,fenc[i].bom,fenc[i].lbom))) {
-          mode=i;                             // BOM found so set mode
-          fseek(fp,fenc[i].lbom,SEEK_SET);    // and skip past BOM 
-          break;
-          }
-        }
-      }   // end of for loop
-    if(mode>1) {    // Cannot read this file encoding mode
-      sprintf(t,"Dictionary %d\nCannot read file encoding:\ntry UTF-8 or ISO-8859-1 encoding",dn+1);
-      if(!sil) reperr(t);
-      rc=-1; goto exit;
-      }
-    if(mode==-1) rewind(fp);    // No BOM, so read words from start of file
-    }
-retry:
-  at=0;
-  freedstrings(dn);
-  memblkl=0; // number of bytes stored so far in current memory block
-  memblkp=0; // current memblk being filled
-  dstrings[dn]=0;
-  clearcounts(dn);
-  DEB_DI printf("Reading dictionary file %s (in mode %d), owd=%d\n",dfnames[dn],mode,owd);
-  for(;;) {       // Loop through dictionary 'words' until EOF
-    if(owd) strcpy(t,dafilters[dn]);
-    else {
-      if(feof(fp)) break;
-      if(fgets(t,SLEN,fp)==NULL) break;
-      line++;
-      }
-    j=strlen(t)-1;
-    if(j<0) goto skipword;
-    while(j>=0&&t[j]>=0&&t[j]<=' ') t[j--]=0;     // Strip control characters/white space from end of string
-    while (j>=0&&((t[j]>='0'&&t[j]<='9')||t[j]=='.'||t[j]=='+'||t[j]=='-')) j--;  // get score (if any) from end
-    j++;
-    f=0.0;
-    if(j==0||t[j-1]!=' ') j=strlen(t); // all digits, or no space? treat it as a 'word'
-    else {
-      sscanf(t+j,"%f",&f);
-      if(f>= 10.0) f= 10.0;
-      if(f<=-10.0) f=-10.0;
-      t[j--]=0; // rest of input is treated as a 'word' (which may contain spaces)
+  rc=0;
+  if(fread(bom,1,4,fp)<4) rewind(fp); // too short for a BOM, so use mode -1
+  else {
+    if(!strncmp(bom,"TSD",3)) {
+      if(newchunk(dn,0,0,0)) {rc=-2; goto exit;}
+      if(loadtsd(fp,bom[3],dch+d->c0)>=0) goto exit; // successfully read
+      freechunks(d->c0,ndch); // read it as text instead
+      ndch=d->c1=d->c0;
+      clearcounts(dn);
       }
-    while(j>=0&&t[j]>=0&&t[j]<=' ') t[j--]=0;  // remove trailing white space
-    j++;
-    if(j<1) goto skipword;
-
-    // t now contains 'word' for conversion; convert it first to UTF-8 for use as citation form
-    if(mode>-1) {     // Use encoding mode based on BOM
-      sp=g_convert(t,-1,"UTF-8",fenc[mode].nenc,NULL,&l0,&error);
-      if(error) {
-        sprintf(t,"Dictionary %d\nFile not encoded in accordance with its BOM",dn+1);
-        if(!sil) reperr(t);
-        rc=-1; goto exit;
-        }
-    } else { // try fallback encodings in turn
-      if(mode==-1) sp=g_convert(t,-1,"UTF-8","UTF-8",NULL,&l0,&error); // effectively a check for valid UTF-8
-      if(mode==-2) sp=g_convert(t,-1,"UTF-8","ISO-8859-1",NULL,&l0,&error);
-      if(error) {
-        DEB_DI {
-          printf("error: %s\n",error->message);
-          for(i=0;t[i];i++) printf(" %02x",t[i]);
-          printf("\n");
+    rewind(fp);
+    if(fgets(bom,5,fp)!=NULL) {       // re-read BOM at start of file
+      for(i=0; i<NFILEENC; i++) {
+        if(fenc[i].lbom>0) {
+          if(!(memcmp(bom,fenc[i].bom,fenc[i].lbom))) {
+            d->mode=i;                          // BOM found so set mode
+            fseek(fp,fenc[i].lbom,SEEK_SET);    // and skip past BOM
+            break;
+            }
           }
-        g_clear_error(&error);
-        freedstrings(dn);
-        rewind(fp);
-        mode--;
-        if(mode>-3) goto retry; // go round again and try next encoding
-        // here if none of the encodings worked 
-        sprintf(t,"Dictionary %d\nFile does not use a recognised encoding:\ntry UTF-8 or ISO-8859-1",dn+1);
+        }   // end of for loop
+      if(d->mode>1) {    // Cannot read this file encoding mode
+        sprintf(t,"Dictionary %d\nCannot read file encoding:\ntry UTF-8 or ISO-8859-1 encoding",dn+1);
         if(!sil) reperr(t);
         rc=-1; goto exit;
         }
+      if(d->mode==-1) rewind(fp);    // No BOM, so read words from start of file
       }
-    // here we have UTF-8 citation form of string in sp, length in l0
-    if(l0>=SLEN) goto skipword;
-    strcpy(s0,sp);
-    g_free(sp),sp=0;
+    }
+  DEB_DI printf("Reading dictionary file %s (in mode %d)\n",dfnames[dn],d->mode);
+
+  // read the rest of the file into memory
+  m=ftell(fp);
+  if(m<0||fseek(fp,0,SEEK_END)<0) {rc=-1; goto exit;}
+  n=ftell(fp)-m;
+  if(n<0||fseek(fp,m,SEEK_SET)<0) {rc=-1; goto exit;}
+  d->buf=(char*)malloc(n+1);
+  if(d->buf==NULL) {rc=-2; goto exit;}
+  n=fread(d->buf,1,n,fp);
+  e=d->buf+n;
+  // cut it at line ends into chunks, counting lines as fgets(t,SLEN,fp) would return them
+  for(p=d->buf,l=0;p<e;p=q) {
+    if(newchunk(dn,p,e,l)) {rc=-2; goto exit;}
+    for(q=p;q<e&&q-p<DCHUNK;) {
+      r=memchr(q,'\n',e-q);
+      r=r?r+1:e;
+      l+=(r-q+SLEN-2)/(SLEN-1); // a line too long for the buffer is read in pieces
+      q=r;
+      }
+    dch[ndch-1].e=q;
+    }
 
-    i=adddictword(s0,dn,sre,are,f);
-    if(i==-2) {rc=-2; goto exit;}
-    if(i==1) at++;
+exit:
+  fclose(fp);
+  return rc;
+  }
 
-skipword:
-    if(sp) g_free(sp),sp=0;
-    g_clear_error(&error);
-    if(owd) break;
-    }  // End of 'word' for loop
+// Gather up the chunks of dictionary dn once they have all been read, reading them again as ISO-8859-1
+// if a file without a BOM turns out not to be UTF-8. Return number of answers loaded or -1 or -2 as for opendict()
+static int closedict(int dn,int sil) {
+  struct dslot*d;
+  struct dchunk*c;
+  struct memblk**pp;
+  int at,i;
+  char t[SLEN];
 
-exit:
-  if(sp) g_free(sp),sp=0;
-  if(sre) pcre_free(sre);
-  if(are) pcre_free(are);
-  g_clear_error(&error);
-  if(!owd) if(fp) fclose(fp);
-  if(rc<0) return rc;
-  else return at;
+  d=dsl+dn;
+  for(;;) {
+    for(i=d->c0;i<d->c1;i++) if(dch[i].rc==-2) return -2;
+    for(i=d->c0;i<d->c1;i++) if(dch[i].rc==-3) break;
+    if(i==d->c1) break; // all read successfully
+    if(d->mode!=-1) {
+      if(d->mode>-1) sprintf(t,"Dictionary %d\nFile not encoded in accordance with its BOM",dn+1);
+      else           sprintf(t,"Dictionary %d\nFile does not use a recognised encoding:\ntry UTF-8 or ISO-8859-1",dn+1);
+      if(!sil) reperr(t);
+      return -1;
+      }
+    d->mode=-2; // go round again and try next encoding
+    freechunks(d->c0,d->c1);
+    clearcounts(dn);
+    for(i=d->c0;i<d->c1;i++) {
+      c=dch+i;
+      c->line=c->line0;
+      c->nw=c->nl=c->nlf=c->nlfa=c->rc=0;
+      }
+    pforeach(d->c1-d->c0,g_get_num_processors(),readchunk,dch+d->c0);
+    }
+  at=0;
+  pp=dstrings+dn;
+  for(i=d->c0;i<d->c1;i++) { // splice string pools together in file order
+    c=dch+i;
+    if(c->first) {*pp=c->first; pp=&c->last->next; c->first=c->last=0;}
+    at+=c->nw;
+    dst_lines[dn]+=c->nl;
+    dst_lines_f[dn]+=c->nlf;
+    dst_lines_fa[dn]+=c->nlfa;
+    }
+  return at;
   }
 
 int loaddicts(int sil) { // load (or reload) dictionaries from dfnames[]
@@ -848,30 +1336,42 @@ int loaddicts(int sil) { // load (or reload) dictionaries from dfnames[]
   // sets dusedmask to list of dictionaries with anything in them
   struct answer*ap;
   struct memblk*p;
-  int at,dn,i,j,k,l,rc,u;
-  char t[SLEN];
+  int at,dn,i,j,k,l,rc,u[MAXNDICTS],dkl;
+  char t[SLEN],*dk;
   unsigned int h;
 
   freedicts();
+  dk=dbnewkey(&dkl); // describe the files before reading them, so that one changed meanwhile is read again next time
+  if(!dbload(dk,dkl)) {free(dk); return 0;} // compiled version is up to date
   at=0;
   rc=0;
   dusedmask=0;
+  dbok=1;
 
+  ndch=0;
+  for(dn=0;dn<MAXNDICTS;dn++) u[dn]=opendict(dn,sil);
+  pforeach(ndch,g_get_num_processors(),readchunk,dch); // read all the chunks of all the dictionaries, one thread per processor
   for(dn=0;dn<MAXNDICTS;dn++) {
-    u=loadonedict(dn,sil);
-    DEB_DI printf("loadonedict(%d) returned %d\n",dn,u);
-    if(u==-2) goto ew4; // out of memory
-    if(u<0) {
+    if(u[dn]==0) u[dn]=closedict(dn,sil);
+    freeslot(dn);
+    }
+  FREEX(dch);
+  ndch=mdch=0;
+  for(dn=0;dn<MAXNDICTS;dn++) {
+    DEB_DI printf("loading dictionary %d returned %d\n",dn,u[dn]);
+    if(u[dn]==-2) goto ew4; // out of memory
+    if(u[dn]<0) {
       rc=1;
       freedstrings(dn);
       }
-    else if(u>0) at+=u,dusedmask|=1<<dn;
+    else if(u[dn]>0) at+=u[dn],dusedmask|=1<<dn;
     }
 
   if(at==0) {  // No words from any dictionary
     sprintf(t,"No words available from any dictionary");
     if(!sil) reperr(t);
     freedicts();
+    free(dk);
     return 2;
     }
   // allocate array space from counts
@@ -923,6 +1423,24 @@ int loaddicts(int sil) { // load (or reload) dictionaries from dfnames[]
     ahtab[h]=i;
     }
 
+  // index answers by untreated length so that the filler need only look at those of the right length
+  alenx=(int*)malloc(atotal*sizeof(int)); if(alenx==NULL) goto ew4;
+  memset(alenst,0,sizeof(alenst));
+  memset(alendm,0,sizeof(alendm));
+  for(i=0;i<atotal;i++) {
+    l=strlen(ansp[i]->ul);
+    assert(l<=MXLE);
+    alenst[l+1]++;
+    alendm[l]|=ansp[i]->dmask;
+    }
+  for(l=0;l<=MXLE;l++) alenst[l+1]+=alenst[l];
+  for(i=0;i<atotal;i++) {
+    l=strlen(ansp[i]->ul);
+    alenx[alenst[l]++]=i;
+    }
+  for(l=MXLE;l>0;l--) alenst[l]=alenst[l-1]; // undo the advances made while filling
+  alenst[0]=0;
+
   for(i=0;i<atotal;i++) {
     if(ansp[i]->score>= 1e10) ansp[i]->score= 1e10; // clamp scores
     if(ansp[i]->score<=-1e10) ansp[i]->score=-1e10;
@@ -938,9 +1456,12 @@ int loaddicts(int sil) { // load (or reload) dictionaries from dfnames[]
     }
 
   DEB_DI printf("Total unique answers by entry: %d\n",atotal);
+  if(rc==0) dbsave(at,dk,dkl);
+  free(dk);
   return rc; // return 1 if any file failed to load
 ew4:
   freedicts();
+  free(dk);
   if(!sil) reperr("Out of memory loading dictionaries");
   return 4;
   }
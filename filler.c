@@ -33,11 +33,14 @@ Calls out:
   mkfeas();
   updatefeas();
   updategrid();
+  dumpsol();
 Calls in:
   filler_init();
   filler_start();
   filler_stop();
   filler_finit();
+  filler_getprogress();
+  filler_writestats();
   getposs();
 */
 
@@ -45,11 +48,16 @@ Calls in:
 #include <gdk/gdk.h>
 #include <time.h>
 #include <float.h>
+#ifdef __AVX2__
+  #include <immintrin.h>
+#endif
 #include "common.h"
 #include "filler.h"
 #include "treatment.h"
 #include "qxw.h"
 #include "gui.h"
+#include "deck.h"
+#include "draw.h"
 #include "dicts.h"
 
 static GThread*fth;
@@ -58,40 +66,191 @@ static int ct_malloc=0,ct_free=0; // counters for debugging
 volatile int abort_flag=0;
 volatile unsigned int filler_seed=0;
 static int fillmode=0; // 0=stopped, 1=filling all, 2=filling selection, 3=word lists only (for preexport)
-static clock_t ct0;
-
-int filler_status=0; // return code: -5: aborted; -3, -4: initflist errors; -2: out of stack; -1: out of memory; 0: stopped; 1: no fill found; 2: fill found; 3: running
-
-// the following stacks keep track of the filler state as it recursively tries to fill the grid
-static int sdep=-1; // stack pointer
-
-static char**sposs=0;                // possibilities for this entry, 0-terminated
-static int*spossp=0;                 // which possibility we are currently trying (index into sposs)
-static int***sflist;                 // pointers to restore feasible word list flist
-static struct jdata***sjdata=0;      // jumble data
-static ABM***sjflbm=0;               // jumble data feasible list bitmaps
-static struct sdata***ssdata=0;      // spread data
-static int**sflistlen=0;             // pointers to restore flistlen
-static ABM**sentryfl=0;              // feasible letter bitmap for this entry
-static int*sentry=0;                 // entry considered at this depth
-
-static unsigned char*aused=0;       // answer already used while filling
-static unsigned char*lused=0;       // light already used while filling
-
-#define isused(l) (lused[lts[l].uniq]|aused[lts[l].ans+NMSG])
-#define setused(l,v) lused[lts[l].uniq]=v,aused[lts[l].ans+NMSG]=v // ,printf("setused(%d,%d)->%d\n",l,v,lts[l].uniq)
-
-static void pstate(int f) {
+int filler_backend=0; // 0=narrow feasible lists by scanning them; 1=narrow using per-word bitset index where worthwhile
+int filler_cbj=0; // 0=chronological backtracking; 1=conflict-directed backjumping; 2=backjumping with learnt nogoods
+int filler_runit=100; // failures allowed in the shortest run between restarts
+double filler_bestsc; // with afbest, total score of the best fill found
+int filler_enum=0; // 0=stop at first fill; 1=count fills; 2=count fills and output each one
+unsigned long filler_enumlim=0; // ... stopping after this many, or 0 for no limit
+unsigned long filler_nsol; // number of fills counted
+int filler_bestopt; // ... and whether it is known to be optimal
+double filler_tlimit=0; // stop filling after this many seconds, or 0 for no limit
+unsigned long filler_nlimit=0; // stop filling after this many decisions, or 0 for no limit
+int filler_limhit; // which limit stopped the fill: 1=time, 2=decisions
+int filler_timing=0; // time settle() and mkscores() at every node for the statistics?
+
+int filler_status=0; // return code: -6: stopped at time or decision limit; -5: aborted; -3, -4: initflist errors; -2: out of stack; -1: out of memory; 0: stopped; 1: no fill found; 2: fill found; 3: running; 4: counted all fills (no fill in entries)
+
+struct scratch { // working space for scounts() and mkscores(), too big for the stack (especially in the Windows version)
+  double ctl[MXFL+1][MXFL+1];   // ctl[i][j] is # of arrangements where chars [0,i) fit in slots [0,j)
+  double ctr[MXFL+1][MXFL+1];   // ctr[i][j] is # of arrangements where chars [i,n) fit in slots [j,m)
+  double tsc[MXFL][MAXICC+1];
+  };
+
+#define NGMAX 1024 // capacity of learnt nogood store
+#define NGMAXLEN 16 // longest nogood worth keeping
+
+struct nogood { // a set of entry=letter assignments that cannot all hold in a fill
+  int n;
+  int e[NGMAXLEN];
+  unsigned char c[NGMAXLEN];
+  };
+
+struct fstats { // search statistics, cheap enough to keep all the time; tset and tsc only with filler_timing
+  unsigned long nodes;          // decisions made
+  unsigned long nbt;            // backtracks
+  unsigned long nbj;            // backjumps
+  unsigned long nngl;           // nogoods learnt
+  unsigned long nrst;           // restarts
+  unsigned long nset;           // settle rounds
+  unsigned long nscan;          // feasible list entries scanned while narrowing word lists
+  unsigned long sdsum;          // sum over decisions of the depth at which they were made
+  int sdmax;                    // greatest depth reached
+  gint64 tbl,tset,tsc;          // microseconds spent in buildlists(), settle() and mkscores()
+  };
+
+// The state of a search: the main filler state works on the global words[] and entries[];
+// each parallel search worker has its own copy of both.
+struct fstate {
+  struct word*words;
+  struct entry*entries;
+  int prog;                     // report progress from this state?
+  clock_t ct0;                  // time of last progress update
+  unsigned int rs;              // random number generator state
+  unsigned int seed;            // ... and its initial value
+  int heur;                     // variable ordering heuristic: 0=most checked then most critical; 1=most critical
+
+  // the following stacks keep track of the filler state as it recursively tries to fill the grid
+  int sdep;                     // stack pointer
+  int bdep;                     // base depth: backtracking stops here
+  char**sposs;                  // possibilities for this entry, 0-terminated
+  int*spossp;                   // which possibility we are currently trying (index into sposs)
+  size_t*strailp;               // trail pointer at start of this depth
+  int*sentry;                   // entry considered at this depth
+
+  int*hp;                       // heap of entries that findcritent() may choose, best first
+  int*hpos;                     // position of each entry in hp, or -1
+  int nhp;
+  unsigned char*efix;           // entry's feasible letter bitmap has one bit set, as last seen by hupd()
+  int nfix;                     // ... and the number of such entries
+
+  double(*wsc)[MAXICC+1];       // cache of each word's contribution to its entries' scores
+  unsigned char*wdirty;         // word's cached scores need recalculating
+  unsigned int*wuep;            // uep when word's cached scores were calculated
+  unsigned int uep;             // incremented whenever used lights change
+  unsigned char*edirty;         // entry's score needs recombining from word score cache
+
+  int*eq;                       // queue of updated entries, i.e., those with upd set
+  int neq;
+  int*wq;                       // queue of updated words, i.e., those with upd set
+  int nwq;
+  int*wl;                       // list of words to be rescanned by settleents()
+  unsigned char*wmk;            // flags words already in wl
+
+  int exn;                      // number of 64-bit words in a set of decision depths
+  uint64_t*ex;                  // for each entry, the decision depths that explain its feasible letter bitmap; then the used lights; then each word
+  unsigned int*exs;             // serial number of the depth at which each set in ex was last saved on the trail
+  unsigned int ser;             // serial number of current depth
+  unsigned int nser;            // last serial number issued
+  size_t exl;                   // trail offset of last saved set in ex, or EXNONE
+  uint64_t*scs;                 // conflict set accumulated at each depth
+  uint64_t*cf;                  // conflict set of the last failure
+  uint64_t*cw;                  // working space
+  struct nogood*ng;             // learnt nogood store, or 0 if not learning
+  int nng;                      // number of nogoods in store
+  int ngp;                      // next one to replace once store is full
+  struct fstats st;             // statistics
+
+  unsigned long nfail;          // failures since the last restart
+  unsigned long rlim;           // ... allowed before the next one, or 0 if never restarting
+  double*ewt;                   // weight of each entry for variable ordering, or 0 if not weighting
+
+  ABM*bfl;                      // best fill found so far, or 0 if not looking for the best fill
+  double bsc;                   // ... its total score, or -DBL_MAX if none yet
+  double*wbest;                 // best score remaining in each word's feasible list
+  gint64 bt0;                   // wall-clock time the search for the best fill started, in microseconds
+  int btout;                    // stopped because time ran out?
+
+  int enm;                      // counting fills rather than stopping at the first?
+
+  char*trail;                   // saved feasible list bitsets, feasible lists with jumble and spread data, and sets in ex
+  size_t trailn;                // amount of trail in use
+  size_t tl;                    // trail offset of last record of a changed entry or word, or TRNONE
+  unsigned int*esv;             // serial number of the depth at which each entry was last saved on the trail
+  unsigned int*wsv;             // ... and likewise each word
+  size_t traila;                // amount of trail allocated
+
+  unsigned char*aused;          // answer already used while filling
+  unsigned char*lused;          // light already used while filling
+  unsigned char*wuf;            // word's feasible list may contain used lights
+
+  int*jrep;                     // for each jumble signature, position in the current word's list of a light checked with it, or -1 if infeasible
+  unsigned int*jmk;             // ... valid if equal to jser
+  unsigned int jser;            // incremented for each pass over a jumbled word's list
+
+  struct scratch*scr;           // working space
+  };
+
+static struct fstate fs0={.prog=1,.sdep=-1,.bdep=-1}; // main filler state
+static struct fstats fstats; // statistics from the last fill
+static int fstatus; // ... and its filler_status
+
+static int*ewds=0;  // words containing each entry: ewds[ewdsi[i]]..ewds[ewdsi[i+1]-1] for entry i, in ascending order
+static int*ewdk=0;  // ... and the position of the entry in each of those words
+static int*ewdsi=0;
+static int*wsco=0;  // index of first row of each word in a state's score cache wsc
+static int*uwds=0;  // with afunique, words whose initial feasible lists contain a light with each uniq: uwds[uwdsi[u]]..uwds[uwdsi[u+1]-1]
+static int*uwdsi=0;
+static int*awds=0;  // ... and likewise for each answer, indexed by ans+NMSG
+static int*awdsi=0;
+static int*ljcls=0; // jumble signature of each light in the initial list of a jumbled word, else -1: lights with equal hist[] and lbm share one
+static int nljcls=0; // number of distinct jumble signatures
+
+#define isused(l) (fs->lused[lts[l].uniq]|fs->aused[lts[l].ans+NMSG])
+#define setused(l,v) fs->lused[lts[l].uniq]=v,fs->aused[lts[l].ans+NMSG]=v // ,printf("setused(%d,%d)->%d\n",l,v,lts[l].uniq)
+
+// parallel search
+#define MAXFTHREADS 64
+int filler_threads=1; // number of threads to search with
+int filler_portfolio=1; // number of independent randomised searches to race against each other
+int filler_pfheur=0; // vary variable ordering heuristic across portfolio?
+int filler_heur=0; // variable ordering heuristic for main search
+unsigned int filler_wseed; // filler seed of the winning portfolio search
+int filler_wheur; // ... and its heuristic
+
+struct ptask { // a subtree of the search to be explored by a worker
+  struct ptask*next;
+  int d;                        // depth of subtree root
+  int*pe;                       // entries fixed on the way down, [0..d-1], followed by entry to expand at depth d
+  char*pc;                      // letters they are fixed to, [0..d-1]
+  char poss[MAXICC+2];          // letters still to try at depth d, 0-terminated
+  };
+
+static int pn;                   // number of workers
+static GMutex*pmutex=0;          // protects the following
+static GCond*pcond=0;            // signalled when a task is queued or the search is finished
+static struct ptask*ptaskq=0;    // tasks waiting for a worker
+static volatile int pnq=0;       // number of tasks in queue
+static volatile int pidle=0;     // number of workers waiting for a task
+static volatile int pstop=0;     // set when a worker has found a fill or the search is otherwise finished
+static int pstatus;              // result of parallel search, as for search()
+static ABM*pfl=0;                // winning fill
+static struct fstate*pwin;       // winning worker
+static int pfmode;               // workers are searching independently as a portfolio?
+
+#define ABORTED (abort_flag||pstop) // told to stop by user, or another worker has finished
+
+static void pstate(struct fstate*fs,int f) {
   int i,j,jmode;
   struct word*w;
 
   for(i=0;i<nw;i++) {
-    w=words+i;
+    w=fs->words+i;
          if(w->lp->emask&EM_JUM) jmode=1;
     else if(w->lp->emask&EM_SPR) jmode=2;
     else                         jmode=0;
     printf("W%d: fe=%d jmode=%d nent=%d wlen=%d jlen=%d E: ",i,w->fe,jmode,w->nent,w->wlen,w->jlen);
-    for(j=0;j<w->nent;j++) printf("%d ",(int)(w->e[j]-entries));
+    for(j=0;j<w->nent;j++) printf("%d ",(int)(w->e[j]-fs->entries));
     printf("= ");
     for(j=0;j<w->nent;j++) pabm(w->e[j]->flbm,1);
     printf("\n");
@@ -118,14 +277,159 @@ static void pstate(int f) {
   }
 
 
-// transfer progress info to display
-static void progress(void) {
+// PROGRESS SNAPSHOTS
+
+// The search publishes its progress without taking the GDK lock: it fills in whichever of two snapshot
+// buffers is not the current one and then advances pgseq, whose bottom bit says which buffer is current.
+// The GUI polls with filler_getprogress() from a timer in the main loop. It copies the current buffer and
+// then checks that pgseq has not moved on meanwhile, as a second snapshot would have started to overwrite
+// the buffer it was reading. Only one filler state at a time has prog set, so there is only one writer.
+
+static ABM*pgbm[2]={0,0};     // feasible letter bitmaps of each entry
+static unsigned long pgnodes[2]; // ... decisions made so far
+static int pgdep[2];          // ... and current depth
+static ABM*pgtmp=0;           // reader's working copy
+static int pgn=0;             // number of entries in each buffer, or 0 if none allocated
+static volatile gint pgseq=0; // number of snapshots published
+static gint pgseen=0;         // ... and of the last one taken up by the GUI
+
+// publish progress info for display
+static void progress(struct fstate*fs) {int b,i,s;
   DEB_F1 printf("ct_malloc=%d ct_free=%d diff=%d\n",ct_malloc,ct_free,ct_malloc-ct_free);
-  gdk_threads_enter();
-  updategrid();
-  gdk_threads_leave();
+  if(pgn!=ne) return;
+  s=g_atomic_int_get(&pgseq);
+  b=(s+1)&1;
+  for(i=0;i<ne;i++) pgbm[b][i]=fs->entries[i].flbm;
+  pgnodes[b]=fs->st.nodes;
+  pgdep[b]=fs->sdep;
+  g_atomic_int_set(&pgseq,s+1);
+  }
+
+// (re)allocate snapshot buffers; called when the filler is not running
+static void pginit(void) {
+  FREEX(pgbm[0]);
+  FREEX(pgbm[1]);
+  FREEX(pgtmp);
+  pgn=0;
+  pgseq=pgseen=0;
+  pgbm[0]=(ABM*)malloc((ne+1)*sizeof(ABM));
+  pgbm[1]=(ABM*)malloc((ne+1)*sizeof(ABM));
+  pgtmp  =(ABM*)malloc((ne+1)*sizeof(ABM));
+  if(pgbm[0]&&pgbm[1]&&pgtmp) pgn=ne;
+  }
+
+// build entry to word map ewds[] and score cache offsets wsco[]; returns !=0 on out of memory
+static int mkewds(void) {int i,j,k;
+  FREEX(ewds);
+  FREEX(ewdk);
+  FREEX(ewdsi);
+  FREEX(wsco);
+  ewdsi=(int*)calloc(ne+1,sizeof(int));
+  if(!ewdsi) return 1;
+  for(i=0;i<nw;i++) for(j=0;j<words[i].nent;j++) ewdsi[words[i].e[j]-entries]++;
+  for(i=1;i<=ne;i++) ewdsi[i]+=ewdsi[i-1]; // now ewdsi[i] is end of list for entry i
+  ewds=(int*)malloc((ewdsi[ne]+1)*sizeof(int));
+  if(!ewds) return 1;
+  ewdk=(int*)malloc((ewdsi[ne]+1)*sizeof(int));
+  if(!ewdk) return 1;
+  for(i=nw-1;i>=0;i--) for(j=words[i].nent-1;j>=0;j--) {
+    k=words[i].e[j]-entries;
+    --ewdsi[k]; // leaves ewdsi[i] at start of list for entry i
+    ewds[ewdsi[k]]=i;
+    ewdk[ewdsi[k]]=j;
+    }
+  wsco=(int*)malloc((nw+1)*sizeof(int));
+  if(!wsco) return 1;
+  for(i=0,wsco[0]=0;i<nw;i++) wsco[i+1]=wsco[i]+words[i].nent;
+  return 0;
+  }
+
+// build index from used light uniq and answer to words uwds[], awds[]; returns !=0 on out of memory
+static int mkuwds(void) {int a,i,j,k,n,*m;
+  FREEX(uwds);
+  FREEX(uwdsi);
+  FREEX(awds);
+  FREEX(awdsi);
+  if(!afunique) return 0;
+  n=MX(ultotal,atotal+NMSG);
+  uwdsi=(int*)calloc(ultotal+1,sizeof(int));
+  awdsi=(int*)calloc(atotal+NMSG+1,sizeof(int));
+  m=(int*)malloc(n*2*sizeof(int)); // last word counted for each uniq, then for each answer
+  if(!uwdsi||!awdsi||!m) {free(m); return 1;}
+  for(i=0;i<n*2;i++) m[i]=-1;
+  for(i=0;i<nw;i++) if(words[i].flist) for(j=0;j<words[i].flistlen;j++) {
+    k=lts[words[i].flist[j]].uniq;
+    a=lts[words[i].flist[j]].ans+NMSG;
+    if(m[k]  !=i) m[k]  =i,uwdsi[k]++;
+    if(m[n+a]!=i) m[n+a]=i,awdsi[a]++;
+    }
+  for(k=1;k<=ultotal;k++) uwdsi[k]+=uwdsi[k-1]; // now uwdsi[k] is end of list for uniq k
+  for(a=1;a<=atotal+NMSG;a++) awdsi[a]+=awdsi[a-1];
+  uwds=(int*)malloc((uwdsi[ultotal]+1)*sizeof(int));
+  awds=(int*)malloc((awdsi[atotal+NMSG]+1)*sizeof(int));
+  if(!uwds||!awds) {free(m); return 1;}
+  for(i=0;i<n*2;i++) m[i]=-1;
+  for(i=nw-1;i>=0;i--) if(words[i].flist) for(j=0;j<words[i].flistlen;j++) {
+    k=lts[words[i].flist[j]].uniq;
+    a=lts[words[i].flist[j]].ans+NMSG;
+    if(m[k]  !=i) m[k]  =i,uwds[--uwdsi[k]]=i; // leaves uwdsi[k] at start of list for uniq k
+    if(m[n+a]!=i) m[n+a]=i,awds[--awdsi[a]]=i;
+    }
+  free(m);
+  return 0;
+  }
+
+// build jumble signatures ljcls[]; returns !=0 on out of memory
+static int mkjcls(void) {int h,i,j,k,l,n,*t;
+  unsigned int c; // signature hash
+  unsigned char*p;
+  FREEX(ljcls);
+  nljcls=0;
+  for(i=0,n=0;i<nw;i++) if(words[i].jdata) n+=words[i].flistlen;
+  if(n==0) return 0;
+  for(h=1;h<n*2;h<<=1) ; // hash table size
+  ljcls=(int*)malloc(ltotal*sizeof(int));
+  t=(int*)malloc(h*sizeof(int)); // light with each signature
+  if(!ljcls||!t) {free(t); return 1;}
+  for(i=0;i<ltotal;i++) ljcls[i]=-1;
+  for(i=0;i<h;i++) t[i]=-1;
+  for(i=0;i<nw;i++) if(words[i].jdata) for(j=0;j<words[i].flistlen;j++) {
+    l=words[i].flist[j];
+    if(ljcls[l]>=0) continue;
+    for(k=0,c=0,p=lts[l].hist;k<MAXICC+1;k++) c=c*31+p[k];
+    for(c&=h-1;t[c]>=0;c=(c+1)&(h-1)) if(lts[t[c]].lbm==lts[l].lbm&&!memcmp(lts[t[c]].hist,p,MAXICC+1)) break;
+    if(t[c]<0) t[c]=l,ljcls[l]=nljcls++;
+    else       ljcls[l]=ljcls[t[c]];
+    }
+  free(t);
+  return 0;
+  }
+
+// light l has just been used: flag the words that might contain it, or another light with the same answer
+static void uflag(struct fstate*fs,int l) {int a,k,u;
+  if(!uwdsi) return;
+  u=lts[l].uniq;
+  a=lts[l].ans+NMSG;
+  for(k=uwdsi[u];k<uwdsi[u+1];k++) fs->wuf[uwds[k]]=1;
+  for(k=awdsi[a];k<awdsi[a+1];k++) fs->wuf[awds[k]]=1;
+  }
+
+// flag entry i as updated, queueing it for settleents()
+static void eupd(struct fstate*fs,int i) {
+  if(fs->entries[i].upd) return;
+  fs->entries[i].upd=1;
+  fs->eq[fs->neq++]=i;
+  }
+
+// flag word i as updated, queueing it for settlewds()
+static void wupd(struct fstate*fs,int i) {
+  if(fs->words[i].upd) return;
+  fs->words[i].upd=1;
+  fs->wq[fs->nwq++]=i;
   }
 
+static int cmpint(const void*p,const void*q) {return *(int*)p-*(int*)q;}
+
 static int initjdata(int j) {struct word*w; int i;
   w=words+j;
   if(!(w->lp->emask&EM_JUM)) return 0;
@@ -140,10 +444,9 @@ static int initjdata(int j) {struct word*w; int i;
 static int initsdata(int j) {struct word*w; int i,k;
   w=words+j;
   if(!(w->lp->emask&EM_SPR)) return 0;
-  if(w->fe) return 0;
-  w->sdata=malloc(w->flistlen*sizeof(struct sdata));
+  w->sdata=malloc(w->flistlen*SDSZ(w)+1);
   if(!w->sdata) return -1;
-  for(i=0;i<w->flistlen;i++) for(k=0;k<w->nent;k++) w->sdata[i].flbm[k]=ABM_ALL;
+  for(i=0;i<w->flistlen;i++) for(k=0;k<w->nent;k++) SDFLBM(w,i)[k]=ABM_ALL;
   return 0;
   }
 
@@ -182,7 +485,8 @@ DEB_F3 { printf("checkperm("); printICCs(f); printf(" : "); printICCs(t); printf
   }
 
 // Approximate test to see if a jumble of #wn in the flist for word w can fit. Writes deductions to flbm etc. in jdata.
-static int checkjword(struct word*w,int wn) {
+// Depends only on the light's hist[] and lbm and the entries' feasible letter bitmaps: see checkjword().
+static int checkjhist(struct word*w,int wn) {
   unsigned char hi[MAXICC+1];
   ABM bm[MXFL],u,v,*jbm;
   unsigned char edone[MXFL]; // entries done
@@ -296,11 +600,36 @@ DEB_F3 {
     pabms(jbm,m,1);
     printf("\n");
     }
+  return 1;
+  }
+
+// Test a jumble of #wn in the flist for word w as checkjhist(), reusing the deductions for an earlier light in this
+// pass with the same signature if there is one. fs->jser must have been incremented at the start of the pass.
+static int checkjword(struct fstate*fs,struct word*w,int wn) {
+  int c,i,k0,m;
+  ABM*jbm;
+
+  m=w->jlen;
+  jbm=w->jflbm+wn*m;
+  c=ljcls[w->flist[wn]];
+  if(fs->jmk[c]==fs->jser) { // signature already checked
+    k0=fs->jrep[c];
+    if(k0<0) return 0;
+    if(k0!=wn) {
+      memcpy(jbm,w->jflbm+k0*m,m*sizeof(ABM));
+      w->jdata[wn]=w->jdata[k0];
+      }
+  } else {
+    fs->jmk[c]=fs->jser;
+    fs->jrep[c]=-1;
+    if(!checkjhist(w,wn)) return 0;
+    fs->jrep[c]=wn;
+    }
   for(i=0;i<m;i++) if(!onebit(jbm[i])) break;
   if(i==m) { // all entries are forced, so we are done
     i=checkperm(w,wn,1); // is it one of the special permutations (reversed etc.) that is disallowed?
 DEB_F3 printf("checkperm returns %d\n",i);
-    if(i==0) return 0;
+    if(i==0) {fs->jmk[c]=0; return 0;} // this position will be overwritten, so forget it
     }
 DEB_F3 printf("checkjword: OK\n");
   return 1;
@@ -309,21 +638,23 @@ DEB_F3 printf("checkjword: OK\n");
 // Calculate number of possible spreads that put each possible letter in each position
 // given implications of flbm:s.
 // should not overflow as 250!/125!/125! < 2^250, which is much less than 1e308
-static void scounts(struct word*w,int wn,ABM*bm) {
-  struct sdata*sd;
+static void scounts(struct fstate*fs,struct word*w,int wn,ABM*bm) {
+  ABM*fl;
+  double*ct,*ctd;
   struct light*l;
   int i,j,m,n;
   ABM u;
-  // following are static to avoid overflowing stack (!) in Windows version
-  static double ctl[MXFL+1][MXFL+1]; // ctl[i][j] is # of arrangements where chars [0,i) fit in slots [0,j)
-  static double ctr[MXFL+1][MXFL+1]; // ctr[i][j] is # of arrangements where chars [i,n) fit in slots [j,m)
+  double(*ctl)[MXFL+1]=fs->scr->ctl; // ctl[i][j] is # of arrangements where chars [0,i) fit in slots [0,j)
+  double(*ctr)[MXFL+1]=fs->scr->ctr; // ctr[i][j] is # of arrangements where chars [i,n) fit in slots [j,m)
 
   l=lts+w->flist[wn];
   m=w->nent;
   n=w->wlen;
-  sd=w->sdata+wn;
+  fl=SDFLBM(w,wn);
+  ct=SDCT(w,wn); // ct[i*m+j]
+  ctd=ct+n*m;
   DEB_F3 { printf("scounts: w=%ld \"",(long int)(w-words)); printICCs(l->s); printf("\"\n"); }
-  memset(ctl,0,sizeof(ctl));
+  memset(ctl,0,sizeof(fs->scr->ctl));
   ctl[0][0]=1;
   for(j=1;j<=m;j++) {
     u=bm[j-1];
@@ -332,7 +663,7 @@ static void scounts(struct word*w,int wn,ABM*bm) {
       if(i>0&&(u&ICCTOABM((int)l->s[i-1]))) ctl[i][j]+=ctl[i-1][j-1];
       }
     }
-  memset(ctr,0,sizeof(ctr));
+  memset(ctr,0,sizeof(fs->scr->ctr));
   ctr[n][m]=1;
   for(j=m-1;j>=0;j--) {
     u=bm[j];
@@ -353,30 +684,25 @@ static void scounts(struct word*w,int wn,ABM*bm) {
       printf("\n");
       }
     }
-//  DEB_F3 {printf("memset0: %p 0 %d wn=%d\n",sd->ct,sizeof(sd->ct),wn); fflush(stdout); }
-  memset(sd->ct,0,sizeof(sd->ct));
-//  DEB_F3 {printf("memset1: %p 0 %d\n",sd->ctd,sizeof(sd->ctd)); fflush(stdout); }
-  memset(sd->ctd,0,sizeof(sd->ctd));
-  for(i=0;i<n;i++) for(j=0;j<m;j++) sd->ct[i][j]=ctl[i][j]*ctr[i+1][j+1];
-  for(j=0;j<m;j++) if(bm[j]&ABM_DASH) for(i=0;i<=n;i++) sd->ctd[j]+=ctl[i][j]*ctr[i][j+1]; // do the spreading character as a special case
+  memset(ctd,0,m*sizeof(double));
+  for(i=0;i<n;i++) for(j=0;j<m;j++) ct[i*m+j]=ctl[i][j]*ctr[i+1][j+1];
+  for(j=0;j<m;j++) if(bm[j]&ABM_DASH) for(i=0;i<=n;i++) ctd[j]+=ctl[i][j]*ctr[i][j+1]; // do the spreading character as a special case
 DEB_F3 {
                       printf("        " ); for(i=0;i<n;i++) printf("  %s   ",icctoutf8[(int)l->s[i]]); printf("      -\n");
-    for(j=0;j<m;j++) {printf("  e%2d:",j); for(i=0;i<n;i++) printf(" %5.1f",sd->ct[i][j]); printf("     %5.1f",sd->ctd[j]); printf("\n");}
+    for(j=0;j<m;j++) {printf("  e%2d:",j); for(i=0;i<n;i++) printf(" %5.1f",ct[i*m+j]); printf("     %5.1f",ctd[j]); printf("\n");}
     }
-  memset(sd->flbm,0,sizeof(sd->flbm));
-  for(i=0;i<n;i++) for(j=0;j<m;j++) if(sd->ct [i][j]) sd->flbm[j]|=ICCTOABM((int)l->s[i]);
-  for                 (j=0;j<m;j++) if(sd->ctd[j])    sd->flbm[j]|=ABM_DASH;
+  memset(fl,0,m*sizeof(ABM));
+  for(i=0;i<n;i++) for(j=0;j<m;j++) if(ct[i*m+j]) fl[j]|=ICCTOABM((int)l->s[i]);
+  for                 (j=0;j<m;j++) if(ctd[j])    fl[j]|=ABM_DASH;
   }
 
-// Test to see if a spread string can fit in a given word. Writes deductions to w->sdata[j].
-static void checksword(struct word*w,int j) {
+// Test to see if a spread string can fit in a given word. Writes deductions to record j of w->sdata.
+static void checksword(struct fstate*fs,struct word*w,int j) {
   ABM bm[MXFL];
   struct light*l;
-  struct sdata*sd;
   int k,m;
 
   l=lts+w->flist[j];
-  sd=w->sdata+j;
   m=w->nent;
   for(k=0;k<m;k++) bm[k]=w->e[k]->flbm;
 DEB_F3 {
@@ -386,174 +712,773 @@ DEB_F3 {
     pabms(bm,m,1);
     printf(" j=%d\n",j);
     }
-  scounts(w,j,bm);
-DEB_F3 { printf("  output bm="); pabms(sd->flbm,m,1); printf("\n"); }
+  scounts(fs,w,j,bm);
+DEB_F3 { printf("  output bm="); pabms(SDFLBM(w,j),m,1); printf("\n"); }
   }
 
-// intersect light list q length l with letter position wp masked by bitmap m: result is stored in p and new length is returned
-static int listisect(int*p,int*q,int l,int wp,ABM m) {int i,j;
-  for(i=0,j=0;i<l;i++) if(m&(ICCTOABM((int)(lts[q[i]].s[wp])))) p[j++]=q[i];
+// intersect light list p length l with letter position wp masked by bitmap m: the lights that remain
+// are moved to the front of p, keeping their order, and their number is returned
+static int listisect(int*p,int l,int wp,ABM m) {int i,j,t;
+  for(i=0,j=0;i<l;i++) if(m&(ICCTOABM((int)(lts[p[i]].s[wp])))) t=p[j],p[j]=p[i],p[i]=t,j++;
   //printf("listisect l(wp=%d m=%16llx) %d->%d\n",wp,m,l,j);
   return j;
   }
 
+// TRAIL
+
+// Feasible lists are narrowed in place: the lights that remain are moved to the front of the list and
+// the others are left after its end, so that backtracking need only restore the list length. The trail
+// is a stack of records of what has to be restored when each depth is popped, made only for the entries
+// and words that actually change: an entry's feasible letter bitmap, saved the first time it changes at
+// each depth; a word's list length and the other per-word data saved the first time it changes at each
+// depth, i.e., the feasible list bitset of a word narrowed using its bitset index, or the whole feasible
+// list with its jumble or spread data, which are indexed by list position; and the commitment of a word.
+// Records are chained latest first and undone in that order.
+
+#define TRAILRND(n) (((n)+7)&~(size_t)7) // keep trail entries aligned
+#define TRNONE ((size_t)-1)
+#define TR_ENTRY -1 // trec.l values for entry and commitment records
+#define TR_COMMIT -2
+
+struct trec { // record on the trail of a change to an entry or word, followed by any saved per-word data
+  size_t prev;                  // trail offset of previous record, or TRNONE
+  int i;                        // which entry or word
+  int l;                        // TR_ENTRY, TR_COMMIT, or the length to restore to the word's feasible list
+  ABM flbm;                     // entry's feasible letter bitmap to restore
+  uint64_t*fbs;                 // word's feasible list bitset pointer to restore
+  };
+
+// make sure there is room for n more bytes on the trail; returns !=0 on out of memory
+static int trailgrow(struct fstate*fs,size_t n) {
+  size_t a;
+  char*t;
+
+  if(fs->trailn+n<=fs->traila) return 0;
+  a=MX(fs->traila*2,fs->trailn+n);
+  if(a<65536) a=65536;
+  t=(char*)realloc(fs->trail,a);
+  if(!t) return 1;
+  if(!fs->trail) ct_malloc++;
+  fs->trail=t;
+  fs->traila=a;
+  return 0;
+  }
+
+// push n bytes at p onto the trail; returns !=0 on out of memory
+static int trailpush(struct fstate*fs,void*p,size_t n) {
+  if(trailgrow(fs,TRAILRND(n))) return 1;
+  memcpy(fs->trail+fs->trailn,p,n);
+  fs->trailn+=TRAILRND(n);
+  return 0;
+  }
+
+// start a record on the trail for entry or word i; returns 0 on out of memory
+static struct trec*trecnew(struct fstate*fs,int i,int l) {
+  struct trec*r;
+
+  if(trailgrow(fs,TRAILRND(sizeof(struct trec)))) return 0;
+  r=(struct trec*)(fs->trail+fs->trailn);
+  r->prev=fs->tl;
+  r->i=i;
+  r->l=l;
+  fs->tl=fs->trailn;
+  fs->trailn+=TRAILRND(sizeof(struct trec));
+  return r;
+  }
+
+// save entry i's feasible letter bitmap on the trail if not already saved at this depth; returns !=0 on out of memory
+static int esave(struct fstate*fs,int i) {
+  struct trec*r;
+
+  if(fs->esv[i]==fs->ser) return 0;
+  r=trecnew(fs,i,TR_ENTRY);
+  if(!r) return 1;
+  r->flbm=fs->entries[i].flbm;
+  fs->esv[i]=fs->ser;
+  return 0;
+  }
+
+// LIGHT COLUMNS
+
+// Scanning a normal-case feasible list through lts[] and the light strings means chasing two pointers for
+// every light. Instead each such word keeps its own copy of the characters of its lights in column-major
+// order, one column per position, along with their scores, and these are permuted along with flist so
+// that the hot loops below run over contiguous bytes. Where the target supports AVX2 the letter bitmap
+// of a column is accumulated four characters at a time.
+
+// build column copy of the feasible list of word w if it is a normal-case word; returns !=0 on out of memory
+static int initcols(struct word*w) {
+  int j,k,l,m;
+  struct light*lt;
+
+  w->fsc=0;
+  w->fcol=0;
+  w->fcs=0;
+  if(!w->flist) return 0;
+  if(w->lp->emask&(EM_JUM|EM_SPR)) return 0; // normal case only
+  l=w->flistlen;
+  m=w->nent;
+  w->fsc=(double*)malloc(l*(sizeof(double)+m)+1); // scores followed by columns
+  if(!w->fsc) return 1;
+  w->fcol=(unsigned char*)(w->fsc+l);
+  w->fcs=l;
+  for(j=0;j<l;j++) {
+    lt=lts+w->flist[j];
+    w->fsc[j]=lt->ans<0?1.0:(double)ansp[lt->ans]->score;
+    for(k=0;k<m;k++) w->fcol[k*l+j]=(unsigned char)lt->s[k];
+    }
+  return 0;
+  }
+
+// move the lights of word w at positions j<l in its feasible list with keep[j]!=0 to the front, keeping
+// their order, and return their number; the same exchanges as listisect() would make are made in flist,
+// fsc and each column of fcol in turn
+static int colpart(struct word*w,int l,unsigned char*keep) {
+  int i,j,k,t;
+  double d;
+  unsigned char c,*q;
+
+  for(i=0;i<l;i++) if(!keep[i]) break;
+  if(i==l) return l; // nothing removed
+  for(j=i;i<l;i++) if(keep[i]) t=w->flist[j],w->flist[j]=w->flist[i],w->flist[i]=t,d=w->fsc[j],w->fsc[j]=w->fsc[i],w->fsc[i]=d,j++;
+  for(k=0;k<w->nent;k++) {
+    q=w->fcol+k*w->fcs;
+    for(i=0;i<l;i++) if(!keep[i]) break;
+    for(j=i;i<l;i++) if(keep[i]) c=q[j],q[j]=q[i],q[i]=c,j++;
+    }
+  return j;
+  }
+
+// intersect the first l lights of the feasible list of normal-case word w with letter position wp masked
+// by bitmap m, as listisect(); returns new length or -1 on out of memory
+static int colisect(struct fstate*fs,struct word*w,int l,int wp,ABM m) {
+  int i;
+  unsigned char*keep,*q;
+
+  if(trailgrow(fs,l)) return -1;
+  keep=(unsigned char*)(fs->trail+fs->trailn); // scratch space on top of the trail
+  q=w->fcol+wp*w->fcs;
+  for(i=0;i<l;i++) keep[i]=(m>>(q[i]-1))&1;
+  return colpart(w,l,keep);
+  }
+
+// remove used lights from the first l of the feasible list of normal-case word w, as settleents() does for
+// other words; returns new length or -1 on out of memory
+static int colunused(struct fstate*fs,struct word*w,int l) {
+  int i;
+  unsigned char*keep;
+
+  if(trailgrow(fs,l)) return -1;
+  keep=(unsigned char*)(fs->trail+fs->trailn);
+  for(i=0;i<l;i++) keep[i]=!isused(w->flist[i]);
+  return colpart(w,l,keep);
+  }
+
+// bitmap of the characters in the first l entries of column q
+static ABM colabm(unsigned char*q,int l) {
+  int j;
+  ABM u0,u1,u2,u3;
+
+  j=0;
+  u0=u1=u2=u3=0;
+#ifdef __AVX2__
+  if(l>=8) {
+    __m256i a,b,one;
+    int x,y;
+    a=b=_mm256_setzero_si256();
+    one=_mm256_set1_epi64x(1);
+    for(;j+8<=l;j+=8) { // widen each character c to 64 bits, form 1<<(c-1) and accumulate
+      memcpy(&x,q+j,4);
+      memcpy(&y,q+j+4,4);
+      a=_mm256_or_si256(a,_mm256_sllv_epi64(one,_mm256_sub_epi64(_mm256_cvtepu8_epi64(_mm_cvtsi32_si128(x)),one)));
+      b=_mm256_or_si256(b,_mm256_sllv_epi64(one,_mm256_sub_epi64(_mm256_cvtepu8_epi64(_mm_cvtsi32_si128(y)),one)));
+      }
+    a=_mm256_or_si256(a,b);
+    u0=_mm256_extract_epi64(a,0);
+    u1=_mm256_extract_epi64(a,1);
+    u2=_mm256_extract_epi64(a,2);
+    u3=_mm256_extract_epi64(a,3);
+    }
+#endif
+  for(;j+4<=l;j+=4) { // independent accumulators so that successive characters need not wait on each other
+    u0|=ICCTOABM((int)q[j  ]);
+    u1|=ICCTOABM((int)q[j+1]);
+    u2|=ICCTOABM((int)q[j+2]);
+    u3|=ICCTOABM((int)q[j+3]);
+    }
+  for(;j<l;j++) u0|=ICCTOABM((int)q[j]);
+  return u0|u1|u2|u3;
+  }
+
+// BITSET INDEX
+
+// For a normal-case word with a long initial feasible list flist0 we build, for each position k and
+// character c, a bitset over flist0 of the lights that have c at position k. The current feasible list is
+// then also held as a bitset fbs, and narrowing an entry becomes a matter of ANDing bitsets together.
+// Once a list gets short compared with the bitsets we revert to listisect() for the rest of that subtree.
+// As flist itself is reordered during the search, flist0 is a copy kept with the index.
+
+#define BSIMIN 256 // minimum initial feasible list length for which a bitset index is built
+#define BSILISTR 16 // stop using bitsets when list length < BSILISTR*number of 64-bit words in a bitset
+
+#ifdef __GNUC__
+  #define popcnt64(x) __builtin_popcountll(x) // these compile to POPCNT and TZCNT/BSF where the target supports them
+  #define ctz64(x) __builtin_ctzll(x)
+#else
+static int popcnt64(uint64_t x) {
+  x=x-((x>>1)&0x5555555555555555ULL);
+  x=(x&0x3333333333333333ULL)+((x>>2)&0x3333333333333333ULL);
+  x=(x+(x>>4))&0x0f0f0f0f0f0f0f0fULL;
+  return (int)((x*0x0101010101010101ULL)>>56);
+  }
+  #define ctz64(x) logbase2((x)&-(x)) // isolate the lowest set bit first
+#endif
+
+#define BSINB(w) (((w)->flistlen0+63)/64) // number of 64-bit words in a bitset over flist0
+
+// build bitset index for word j if appropriate; returns !=0 on out of memory
+static int initbsi(int j) {
+  struct word*w;
+  int c,i,k,m,n,nb;
+  ABM pres[MXFL];
+  uint64_t*b;
+
+  w=words+j;
+  w->flist0=0;
+  w->fsc0=0;
+  w->fcol0=0;
+  w->flistlen0=w->flistlen;
+  if(filler_backend!=1) return 0;
+  if(w->lp->emask&(EM_JUM|EM_SPR)) return 0; // normal case only
+  if(w->fe||w->flistlen<BSIMIN) return 0; // not worth it
+  m=w->nent;
+  nb=BSINB(w);
+  for(k=0;k<m;k++) pres[k]=0;
+  for(i=0;i<w->flistlen;i++) for(k=0;k<m;k++) pres[k]|=ICCTOABM((int)lts[w->flist[i]].s[k]); // characters present at each position
+  for(k=0,n=0;k<m;k++) n+=cbits(pres[k]);
+  w->bsi=(uint64_t**)malloc(m*(MAXICC+1)*sizeof(uint64_t*)+n*nb*sizeof(uint64_t)+w->flistlen*(sizeof(double)+sizeof(int)+m)); // pointer table followed by bitsets, fsc0, flist0 and fcol0
+  if(!w->bsi) return -1;
+  w->fbs=(uint64_t*)malloc(nb*sizeof(uint64_t));
+  if(!w->fbs) return -1;
+  b=(uint64_t*)(w->bsi+m*(MAXICC+1));
+  memset(b,0,n*nb*sizeof(uint64_t));
+  for(k=0;k<m;k++) for(c=0;c<MAXICC+1;c++) {
+    if(c>0&&(pres[k]&ICCTOABM(c))) w->bsi[k*(MAXICC+1)+c]=b,b+=nb;
+    else                           w->bsi[k*(MAXICC+1)+c]=0;
+    }
+  w->fsc0=(double*)b;
+  memcpy(w->fsc0,w->fsc,w->flistlen*sizeof(double));
+  w->flist0=(int*)(w->fsc0+w->flistlen);
+  memcpy(w->flist0,w->flist,w->flistlen*sizeof(int));
+  w->fcol0=(unsigned char*)(w->flist0+w->flistlen);
+  memcpy(w->fcol0,w->fcol,w->flistlen*m);
+  for(i=0;i<w->flistlen;i++) for(k=0;k<m;k++) w->bsi[k*(MAXICC+1)+lts[w->flist[i]].s[k]][i>>6]|=1ULL<<(i&63);
+  for(i=0;i<nb;i++) w->fbs[i]=~0ULL;
+  if(w->flistlen&63) w->fbs[nb-1]=(1ULL<<(w->flistlen&63))-1;
+  DEB_F1 printf("W%d: bitset index %d lights x %d bitsets\n",j,w->flistlen,n);
+  return 0;
+  }
+
+// copy entry j of flist0 of word w to position i of its feasible list
+static void bsiput(struct word*w,int i,int j) {
+  int k;
+
+  w->flist[i]=w->flist0[j];
+  w->fsc[i]=w->fsc0[j];
+  for(k=0;k<w->nent;k++) w->fcol[k*w->fcs+i]=w->fcol0[k*w->flistlen0+j];
+  }
+
+// Narrow the feasible list of word w using its bitset index. w->fbs is intersected with the index
+// bitsets of each updated entry and, if afunique and any might be present, used lights are removed. The new feasible list is
+// written to the front of w->flist in flist0 order, followed by the lights removed, and its length
+// returned; or -1 on out of memory. fsc and fcol are rewritten to match.
+static int bsisect(struct fstate*fs,struct word*w) {
+  int c,i,j,k,l,n0,n1,nb;
+  uint64_t u,*b,*o,**bsi,*ib0[MAXICC+1],*ib1[MAXICC+1];
+  ABM m;
+
+  nb=BSINB(w);
+  b=w->fbs;
+  if(trailgrow(fs,nb*sizeof(uint64_t))) return -1;
+  o=(uint64_t*)(fs->trail+fs->trailn); // copy of the old bitset, in scratch space on top of the trail
+  memcpy(o,b,nb*sizeof(uint64_t));
+  for(k=0;k<w->nent;k++) {
+    if(!w->e[k]->upd) continue;
+    m=w->e[k]->flbm;
+    bsi=w->bsi+k*(MAXICC+1);
+    for(c=1,n0=0,n1=0;c<MAXICC+1;c++) if(bsi[c]) { // sort index bitsets into allowed and disallowed characters
+      if(m&ICCTOABM(c)) ib0[n0++]=bsi[c];
+      else              ib1[n1++]=bsi[c];
+      }
+    if(n1==0) continue; // nothing in the list is excluded at this position
+    if(n0<=n1) { // intersect with union of allowed characters
+      for(i=0;i<nb;i++) if(b[i]) {
+        for(u=0,j=0;j<n0;j++) u|=ib0[j][i];
+        b[i]&=u;
+        }
+    } else { // remove union of disallowed characters
+      for(i=0;i<nb;i++) if(b[i]) {
+        for(u=0,j=0;j<n1;j++) u|=ib1[j][i];
+        b[i]&=~u;
+        }
+      }
+    }
+  l=0;
+  if(afunique&&fs->wuf[w-fs->words]) { // remove used lights while building the list
+    for(i=0;i<nb;i++) for(u=b[i];u;u&=u-1) {
+      j=i*64+ctz64(u);
+      if(isused(w->flist0[j])) b[i]&=~(1ULL<<(j&63));
+      else                     bsiput(w,l++,j);
+      }
+  } else {
+    for(i=0;i<nb;i++) l+=popcnt64(b[i]);
+    if(l==0) return 0; // flist still holds the old list, which is all we need
+    for(i=0,l=0;i<nb;i++) for(u=b[i];u;u&=u-1) bsiput(w,l++,i*64+ctz64(u));
+    }
+  for(i=0,j=l;i<nb;i++) for(u=o[i]&~b[i];u;u&=u-1) bsiput(w,j++,i*64+ctz64(u)); // removed lights
+  return l;
+  }
+
+// CRITICAL ENTRY HEAP
+
+// The entries that findcritent() may choose are held in a binary heap ordered as it would choose them:
+// with heuristic 0 the most checked entry, then the lowest crux, then the lowest index; with heuristic 1
+// just the lowest crux, then the lowest index. Entries whose crux is not less than DBL_MAX are never
+// chosen, and with heuristic 0 nor are entries in no light; unchecked entries come after all checked
+// ones. hupd() must be called whenever an entry's crux changes or it becomes fixed or unfixed; it also
+// keeps the count of fixed entries that partial() uses.
+
+// can entry i be chosen?
+static int hok(struct fstate*fs,int i) {
+  struct entry*e=fs->entries+i;
+
+  if(fillmode==2&&e->sel==0) return 0; // filling selection only: only check relevant entries
+  if(onebit(e->flbm)) return 0; // already fixed
+  if(!(e->crux<DBL_MAX)) return 0;
+  if(fs->heur==0&&e->checking<1) return 0;
+  return 1;
+  }
+
+// should entry i be chosen before entry j?
+static int hbefore(struct fstate*fs,int i,int j) {
+  struct entry*e=fs->entries+i,*f=fs->entries+j;
+
+  if(fs->heur==0&&e->checking!=f->checking) return e->checking>f->checking;
+  if(fs->ewt) {
+    if(e->crux/fs->ewt[i]!=f->crux/fs->ewt[j]) return e->crux/fs->ewt[i]<f->crux/fs->ewt[j];
+  } else if(e->crux!=f->crux) return e->crux<f->crux;
+  return i<j;
+  }
+
+static void hset(struct fstate*fs,int p,int i) {fs->hp[p]=i; fs->hpos[i]=p;}
+
+// restore heap order around position p
+static void hsift(struct fstate*fs,int p) {
+  int c,i;
+
+  i=fs->hp[p];
+  while(p>0&&hbefore(fs,i,fs->hp[(p-1)/2])) hset(fs,p,fs->hp[(p-1)/2]),p=(p-1)/2; // up
+  for(;;) { // down
+    c=p*2+1;
+    if(c>=fs->nhp) break;
+    if(c+1<fs->nhp&&hbefore(fs,fs->hp[c+1],fs->hp[c])) c++;
+    if(!hbefore(fs,fs->hp[c],i)) break;
+    hset(fs,p,fs->hp[c]);
+    p=c;
+    }
+  hset(fs,p,i);
+  }
+
+// bring the heap up to date with the state of entry i
+static void hupd(struct fstate*fs,int i) {
+  int f,p;
+
+  f=onebit(fs->entries[i].flbm);
+  if(f!=fs->efix[i]) fs->efix[i]=f,fs->nfix+=f?1:-1;
+  p=fs->hpos[i];
+  if(hok(fs,i)) {
+    if(p<0) p=fs->nhp++,hset(fs,p,i); // insert
+    hsift(fs,p);
+  } else if(p>=0) { // remove
+    fs->hpos[i]=-1;
+    if(--fs->nhp==p) return;
+    hset(fs,p,fs->hp[fs->nhp]);
+    hsift(fs,p);
+    }
+  }
+
+// build the heap from scratch
+static void hbuild(struct fstate*fs) {int i;
+  fs->nhp=0;
+  fs->nfix=0;
+  for(i=0;i<ne;i++) fs->hpos[i]=-1,fs->efix[i]=0;
+  for(i=0;i<ne;i++) hupd(fs,i);
+  }
+
 // find the entry to expand next, or -1 if all done
-static int findcritent(void) {int i,j,m;double k,l;
-  m=-1;
-  for(i=0;i<ne;i++) {
-    if(fillmode==2&&entries[i].sel==0) continue; // filling selection only: only check relevant entries
-    if(onebit(entries[i].flbm)) continue;
-    if(entries[i].checking>m) m=entries[i].checking; // find highest checking level // find highest checking level
-    }
-  j=-1;
-  for(;m>0;m--) { // m>=2: loop over checked entries; then m=1: loop over unchecked entries
-    j=-1;l=DBL_MAX;
-    for(i=0;i<ne;i++) {
-      if(fillmode==2&&entries[i].sel==0) continue; // filling selection only: only check relevant entries
-      if(!onebit(entries[i].flbm)&&entries[i].checking>=m) { // not already fixed?
-        k=entries[i].crux; // get the priority for this entry
-        if(k<l) l=k,j=i;}
+static int findcritent(struct fstate*fs) {
+  return fs->nhp?fs->hp[0]:-1;
+  }
+
+// RESTARTS
+
+// With afrestart set a serial or portfolio search that has met with more than rlim failures since it last
+// (re)started goes back to the root and starts again, now with at least slightly randomised ordering of
+// possibilities, the random number generator carrying on where it left off. The limit grows on a Luby
+// (afrestart==1) or geometric (afrestart==2) schedule in units of filler_runit, so eventually a run will
+// exhaust the tree if there is no fill. With afrweights set as well, every entry of a word that is wiped out
+// gains weight, which is kept across restarts; lower crux divided by weight is then chosen first.
+
+// i'th term (i>=1) of the Luby sequence 1,1,2,1,1,2,4,1,1,2,...
+static unsigned long luby(unsigned long i) {int k;
+  for(;;) {
+    for(k=1;((1UL<<k)-1)<i;k++) ;
+    if(i==(1UL<<k)-1) return 1UL<<(k-1);
+    i-=(1UL<<(k-1))-1;
+    }
+  }
+
+// failures allowed before restart number n+1
+static unsigned long rlimit(unsigned long n) {double u;
+  if(afrestart==1) return filler_runit*luby(n+1);
+  u=filler_runit;
+  while(n--&&u<1e15) u*=1.5;
+  return (unsigned long)u;
+  }
+
+// set up restarts for a search from the root
+static void rinit(struct fstate*fs) {
+  fs->nfail=0;
+  fs->rlim=(afrestart&&fillmode!=0&&fillmode!=3&&!fs->bfl&&!fs->enm)?rlimit(0):0;
+  }
+
+// word w has been wiped out: weight its entries
+static void wbump(struct fstate*fs,struct word*w) {int k,i;
+  if(!fs->ewt) return;
+  for(k=0;k<w->nent;k++) {
+    i=w->e[k]-fs->entries;
+    fs->ewt[i]+=1;
+    hupd(fs,i);
+    }
+  }
+
+// BACKJUMPING
+
+// With filler_cbj set, each entry carries the set of decision depths (bit d for the letter fixed on the way
+// down to depth d) whose choices, by propagation, account for its feasible letter bitmap. Each word carries
+// the union of the sets of the entries (and, if afunique, of the used lights) that have actually removed
+// lights from its feasible list; the used lights carry the sets of the entries of the words committed.
+// When a word is wiped out its set is the conflict set of the failure. If the latest decision is not in it the
+// search can jump straight back to the deepest one that is; otherwise the conflict set, less that decision,
+// is added to the set for its depth, which when exhausted fails in turn with what it has collected. With
+// filler_cbj==2 the conflict set of each exhausted depth is also kept, as long as it is short, as a nogood:
+// a set of entry=letter assignments that is then checked during propagation. Possibilities given away to
+// another worker have not been refuted by us, so a depth that has donated (or is replaying a task) marks its
+// conflict set with bit 0, which stops both jumping past it and learning from it.
+
+struct exrec { // saved set on the trail, followed by the set itself
+  size_t prev;                  // trail offset of previous saved set, or EXNONE
+  int i;                        // which set
+  };
+
+#define EXNONE ((size_t)-1)
+#define EXSET(fs,i) ((fs)->ex+(size_t)(i)*(fs)->exn) // set for entry i; i==ne for used lights; i==ne+1+j for word j
+#define EXTST(b,d) (((b)[(d)>>6]>>((d)&63))&1)
+#define EXBIS(b,d) ((b)[(d)>>6]|=1ULL<<((d)&63))
+#define EXBIC(b,d) ((b)[(d)>>6]&=~(1ULL<<((d)&63)))
+
+static void exclr(struct fstate*fs,uint64_t*b) {memset(b,0,fs->exn*sizeof(uint64_t));}
+static void exor(struct fstate*fs,uint64_t*b,uint64_t*c) {int i; for(i=0;i<fs->exn;i++) b[i]|=c[i];}
+
+// save set i on the trail if not already saved at this depth; returns !=0 on out of memory
+static int exsave(struct fstate*fs,int i) {
+  size_t n;
+  struct exrec*r;
+
+  if(fs->exs[i]==fs->ser) return 0;
+  n=sizeof(struct exrec)+fs->exn*sizeof(uint64_t);
+  if(trailgrow(fs,TRAILRND(n))) return 1;
+  r=(struct exrec*)(fs->trail+fs->trailn);
+  r->prev=fs->exl;
+  r->i=i;
+  memcpy(r+1,EXSET(fs,i),fs->exn*sizeof(uint64_t));
+  fs->exl=fs->trailn;
+  fs->trailn+=TRAILRND(n);
+  fs->exs[i]=fs->ser;
+  return 0;
+  }
+
+// add to b the decisions that account for the feasible list of word w and, in the jumble and spread
+// cases, the data derived from it
+static void wexpl(struct fstate*fs,struct word*w,uint64_t*b) {int k;
+  exor(fs,b,EXSET(fs,ne+1+(w-fs->words)));
+  if(w->lp->emask&(EM_JUM|EM_SPR)) for(k=0;k<w->nent;k++) exor(fs,b,EXSET(fs,w->e[k]-fs->entries));
+  }
+
+// set i (an entry, or ne for used lights) has removed lights from the feasible list of word w; returns
+// !=0 on out of memory
+static int exwadd(struct fstate*fs,struct word*w,int i) {int j;
+  j=ne+1+(w-fs->words);
+  if(exsave(fs,j)) return 1;
+  exor(fs,EXSET(fs,j),EXSET(fs,i));
+  return 0;
+  }
+
+// word w has been wiped out: set conflict set accordingly
+static void wfail(struct fstate*fs,struct word*w) {
+  if(!fs->ex) return;
+  exclr(fs,fs->cf);
+  wexpl(fs,w,fs->cf);
+  }
+
+// entry e has been fixed by the decision at the current depth; returns !=0 on out of memory
+static int exdecide(struct fstate*fs,int e) {
+  if(!fs->ex) return 0;
+  if(exsave(fs,e)) return 1;
+  exclr(fs,EXSET(fs,e));
+  EXBIS(EXSET(fs,e),fs->sdep);
+  return 0;
+  }
+
+// start the conflict set at the current depth, where the possibilities for entry e have just been found:
+// they depend on its feasible letter bitmap and on the scores from the words it is in
+static void exnode(struct fstate*fs,int e) {int k;
+  uint64_t*b;
+
+  if(!fs->ex) return;
+  b=fs->scs+(size_t)fs->sdep*fs->exn;
+  exclr(fs,b);
+  exor(fs,b,EXSET(fs,e));
+  for(k=ewdsi[e];k<ewdsi[e+1];k++) wexpl(fs,fs->words+ewds[k],b);
+  if(afunique) exor(fs,b,EXSET(fs,ne)); // scores leave out used lights
+  }
+
+// the last failure was not explained by propagation: it depends on every decision so far
+static void exfailall(struct fstate*fs) {int i;
+  if(!fs->ex) return;
+  exclr(fs,fs->cf);
+  for(i=0;i<=fs->sdep;i++) EXBIS(fs->cf,i);
+  }
+
+// the possibilities at depth d are not all ours to refute
+static void extaint(struct fstate*fs,int d) {int i;
+  uint64_t*b;
+
+  if(!fs->ex) return;
+  b=fs->scs+(size_t)d*fs->exn;
+  exclr(fs,b);
+  for(i=0;i<=d;i++) EXBIS(b,i);
+  }
+
+// keep the conflict set of the failure as a nogood if it is short and sound
+static void nglearn(struct fstate*fs) {
+  int d,n;
+  struct nogood*g;
+
+  if(!fs->ng) return;
+  if(EXTST(fs->cf,0)) return; // tainted
+  for(d=1,n=0;d<=fs->sdep;d++) if(EXTST(fs->cf,d)) n++;
+  if(n==0||n>NGMAXLEN) return;
+  if(fs->nng<NGMAX) g=fs->ng+fs->nng++;
+  else {g=fs->ng+fs->ngp; fs->ngp=(fs->ngp+1)%NGMAX;} // replace oldest
+  g->n=0;
+  for(d=1;d<=fs->sdep;d++) if(EXTST(fs->cf,d)) { // the decision at depth d was made at depth d-1
+    g->e[g->n]=fs->sentry[d-1];
+    g->c[g->n]=fs->sposs[d-1][fs->spossp[d-1]-1];
+    g->n++;
+    }
+  fs->st.nngl++;
+  DEB_F1 {printf("learnt nogood:"); for(n=0;n<g->n;n++) printf(" E%d=%s",g->e[n],icctoutf8[g->c[n]]); printf("\n");}
+  }
+
+// check learnt nogoods against the current entry bitmaps: if all but one of a nogood's assignments hold,
+// the remaining letter is removed from its entry
+// returns -2 if a nogood holds entirely, -1 for out of memory, 0 if nothing changed, >0 otherwise
+static int ngcheck(struct fstate*fs) {
+  int e,f,i,j,u;
+  ABM b;
+  struct nogood*g;
+
+  f=0;
+  for(i=0;i<fs->nng;i++) {
+    g=fs->ng+i;
+    for(j=0,u=-1;j<g->n;j++) {
+      b=fs->entries[g->e[j]].flbm;
+      if(!(b&ICCTOABM(g->c[j]))) break; // assignment excluded: nogood cannot apply
+      if(b!=ICCTOABM(g->c[j])) { // assignment still open
+        if(u>=0) break; // more than one
+        u=j;
+        }
       }
-    if(j!=-1) return j; // return entry with highest priority if one found
+    if(j<g->n) continue;
+    exclr(fs,fs->cw);
+    for(j=0;j<g->n;j++) if(j!=u) exor(fs,fs->cw,EXSET(fs,g->e[j]));
+    if(u<0) {memcpy(fs->cf,fs->cw,fs->exn*sizeof(uint64_t)); return -2;}
+    e=g->e[u];
+    if(exsave(fs,e)) return -1;
+    exor(fs,EXSET(fs,e),fs->cw);
+    if(esave(fs,e)) return -1;
+    fs->entries[e].flbm&=~ICCTOABM(g->c[u]);
+    eupd(fs,e);f++;
+    hupd(fs,e);
     }
-  return j; // return -1 if no entries left to expand
+  return f;
   }
 
 // check updated entries and rebuild feasible word lists
 // returns -3 for aborted, -2 for infeasible, -1 for out of memory, 0 if no feasible word lists affected, >=1 otherwise
-static int settleents(void) {
+static int settleents(struct fstate*fs) {
   struct entry*e;
   struct word*w;
-  struct jdata*jd;
-  struct sdata*sd;
-  ABM*jdf;
-  int aed,f,i,j,k,l,m,mj,jmode;
+  int aed,f,i,j,k,l,l0,m,mj,n,q,jmode,t;
   int*p;
+  struct trec*r;
 //  DEB_F1 printf("settleents() sdep=%d\n",sdep);
   f=0;
-  for(j=0;j<nw;j++) {
-    if(abort_flag) return -3;
-    w=words+j;
+  for(i=0,n=0;i<fs->neq;i++) for(k=ewdsi[fs->eq[i]];k<ewdsi[fs->eq[i]+1];k++) { // find words through updated entries
+    j=ewds[k];
+    if(!fs->wmk[j]) fs->wmk[j]=1,fs->wl[n++]=j;
+    }
+  qsort(fs->wl,n,sizeof(int),cmpint); // take them in the same order as a sweep over all words would
+  for(q=0;q<n;q++) fs->wmk[fs->wl[q]]=0;
+  for(q=0;q<n;q++) {
+    if(ABORTED) return -3;
+    j=fs->wl[q];
+    w=fs->words+j;
          if(w->lp->emask&EM_JUM) jmode=1;
     else if(w->lp->emask&EM_SPR) jmode=2;
     else                         jmode=0;
 //    printf("j=%d jmode=%d emask=%d\n",j,jmode,w->lp->emask);
     m=w->nent;
     mj=w->jlen;
-    for(k=0;k<m;k++) if(w->e[k]->upd) break;
-    if(k==m) continue; // no update flags set on any entries for this word
     for(k=0;k<m;k++) if(!onebit(w->e[k]->flbm)) break;
     aed=(k==m); // all entries determined?
+    fs->wdirty[j]=1; // feasible list may be reordered or narrowed, or jumble or spread data changed
     p=w->flist;
     l=w->flistlen;
-    jd=w->jdata;
-    sd=w->sdata;
     if(!p) continue; // no flist?
-    if(sflistlen[sdep][j]==-1) {  // then we mustn't trash words[].flist
-      sflist   [sdep][j]=p;
-      sflistlen[sdep][j]=l;
-      sjdata   [sdep][j]=jd;
-      sjflbm   [sdep][j]=w->jflbm;
-      ssdata   [sdep][j]=sd;
-      w->jdata=0;
-      w->jflbm=0;
-      w->sdata=0;
-      w->flist=(int*)malloc(l*sizeof(int)); // new list can be at most as long as old one
-      if(!w->flist) return -1; // out of memory
-      ct_malloc++;
-      if(jmode==1) {
-        w->jdata=(struct jdata*)malloc(l*sizeof(struct jdata));
-        if(!w->jdata) return -1; // out of memory
-        ct_malloc++;
-        w->jflbm=(ABM*)malloc(l*mj*sizeof(ABM));
-        if(!w->jflbm) return -1; // out of memory
-        ct_malloc++;
+    if(fs->wsv[j]!=fs->ser) {  // first change at this depth: save what we need to restore it
+      r=trecnew(fs,j,l);
+      if(!r) return -1; // out of memory
+      r->fbs=w->fbs;
+      fs->wsv[j]=fs->ser;
+      if(w->fbs) {
+        if(l<BSILISTR*BSINB(w)) w->fbs=0; // list now short enough that scanning it is quicker
+        else if(trailpush(fs,w->fbs,BSINB(w)*sizeof(uint64_t))) return -1; // out of memory
         }
-      if(jmode==2) {
-        w->sdata=(struct sdata*)malloc(l*sizeof(struct sdata));
-        if(!w->sdata) return -1; // out of memory
-        ct_malloc++;
+      if(w->jdata) {
+        if(trailpush(fs,p,l*sizeof(int))) return -1;
+        if(trailpush(fs,w->jdata,l*sizeof(struct jdata))) return -1;
+        if(trailpush(fs,w->jflbm,l*mj*sizeof(ABM))) return -1;
+        }
+      if(w->sdata) {
+        if(trailpush(fs,p,l*sizeof(int))) return -1;
+        if(trailpush(fs,w->sdata,l*SDSZ(w))) return -1;
         }
       }
-    if(afunique) { // the following test makes things quite a lot slower: consider optimising by keeping track of when an update might be needed
-      for(i=0,k=0;i<l;i++) if(!isused(p[i])) w->flist[k++]=p[i];
-      p=w->flist;
-      l=k;
+    if(afunique&&fs->wuf[j]&&!w->fbs) { // a light that might be in the list has been used since it was last filtered
+      l0=l;
+      fs->st.nscan+=l;
+      if(w->fsc) {
+        l=colunused(fs,w,l);
+        if(l<0) return -1; // out of memory
+      } else {
+        for(i=0,k=0;i<l;i++) if(!isused(p[i])) t=p[k],p[k]=p[i],p[i]=t,k++;
+        l=k;
+        }
+      if(fs->ex&&l<l0&&exwadd(fs,w,ne)) return -1;
+      fs->wuf[j]=0;
       }
 
-    if(jmode==0) { // normal case
-      for(k=0;k<m;k++) { // think about moving this loop inside listisect()
+    l0=l;
+    if(jmode==0&&w->fbs) { // normal case using bitset index
+      fs->st.nscan+=l;
+      l=bsisect(fs,w);
+      if(l<0) return -1; // out of memory
+      fs->wuf[j]=0;
+      if(fs->ex&&l<l0) { // we do not know which positions were responsible
+        for(k=0;k<m;k++) if(w->e[k]->upd&&exwadd(fs,w,w->e[k]-fs->entries)) return -1;
+        if(afunique&&exwadd(fs,w,ne)) return -1;
+        }
+    } else if(jmode==0) { // normal case
+      for(k=0;k<m;k++) {
         e=w->e[k];
         if(!e->upd) continue;
-        l=listisect(w->flist,p,l,k,e->flbm); // generate new feasible word list
-        p=w->flist;
+        l0=l;
+        fs->st.nscan+=l;
+        l=colisect(fs,w,l,k,e->flbm); // generate new feasible word list
+        if(l<0) return -1; // out of memory
+        if(fs->ex&&l<l0&&exwadd(fs,w,e-fs->entries)) return -1;
         if(l==0) break;
         }
     } else if(jmode==1) { // jumble case
       for(k=mj;k<m;k++) { // loop over tags if any
         e=w->e[k];
         if(!e->upd) continue;
-        l=listisect(w->flist,p,l,k,e->flbm); // generate new feasible word list
-        p=w->flist;
+        fs->st.nscan+=l;
+        l=listisect(p,l,k,e->flbm); // generate new feasible word list
+        }
+      if(!fs->jrep) { // first jumbled word for this state
+        fs->jrep=(int*)malloc(nljcls*sizeof(int));
+        fs->jmk=(unsigned int*)calloc(nljcls,sizeof(unsigned int));
+        if(!fs->jrep||!fs->jmk) return -1; // out of memory
+        fs->jser=0;
         }
-      for(i=0,k=0;i<l;i++) {w->flist[k]=p[i]; if(checkjword(w,k)) k++;}
+      if(++fs->jser==0) memset(fs->jmk,0,nljcls*sizeof(unsigned int)),fs->jser=1;
+      fs->st.nscan+=l;
+      for(i=0,k=0;i<l;i++) {t=p[k],p[k]=p[i],p[i]=t; if(checkjword(fs,w,k)) k++;}
       l=k;
-      w->upd=1; f++; // need to do settlents() anyway in this case
+      wupd(fs,j); f++; // need to do settlents() anyway in this case
     } else { // spread case
-      for(i=0;i<l;i++) {w->flist[i]=p[i]; checksword(w,i);}
-      w->upd=1; f++; // need to do settlents() anyway in this case
+      fs->st.nscan+=l;
+      for(i=0;i<l;i++) checksword(fs,w,i);
+      wupd(fs,j); f++; // need to do settlents() anyway in this case
       }
-
-    if(l!=w->flistlen) {
-      w->upd=1;f++; // word list has changed: feasible letter lists will need updating
-      if(l) {
-        p=realloc(w->flist,l*sizeof(int));
-        if(p) w->flist=p;
-        if(w->jdata) {
-          jd=realloc(w->jdata,l*sizeof(struct jdata));
-          if(jd) w->jdata=jd;
-          jdf=realloc(w->jflbm,l*mj*sizeof(ABM));
-          if(jdf) w->jflbm=jdf;
-          }
-        if(w->sdata) {
-          sd=realloc(w->sdata,l*sizeof(struct sdata));
-          if(sd) w->sdata=sd;
-          }
-        }
+    if(fs->ex&&jmode!=0&&l<l0) { // wexpl() includes the entries themselves in these cases
+      if(afunique&&exwadd(fs,w,ne)) return -1;
       }
+
+    if(l!=w->flistlen) {wupd(fs,j);f++;} // word list has changed: feasible letter lists will need updating
     w->flistlen=l;
-    if(l==0&&!w->fe) return -2; // no options left and was not fully entered by user
+    if(l==0&&!w->fe) {wfail(fs,w); wbump(fs,w); return -2;} // no options left and was not fully entered by user
     if(!aed) continue; // not all entries determined yet, so don't commit
     if(jmode==1) { // final check that the "jumble" is not actually a cyclic permutation etc.
-      for(i=0,k=0;i<l;i++) {w->flist[k]=w->flist[i]; if(checkperm(w,k,0)) k++;}
+      for(i=0,k=0;i<l;i++) {t=p[k],p[k]=p[i],p[i]=t; if(checkperm(w,k,0)) k++;}
       l=k;
       }
     w->flistlen=l;
-    if(l==0&&!w->fe) return -2; // no options left and was not fully entered by user
+    if(l==0&&!w->fe) {wfail(fs,w); wbump(fs,w); return -2;} // no options left and was not fully entered by user
     assert(w->commitdep==-1);
-    for(k=0;k<l;k++) setused(w->flist[k],1); // flag as used (can be more than one in jumble case)
-    w->commitdep=sdep;
+    for(k=0;k<l;k++) setused(w->flist[k],1),uflag(fs,w->flist[k]); // flag as used (can be more than one in jumble case)
+    fs->uep++;
+    if(fs->ex&&afunique) { // used lights now also depend on what determined this word
+      if(exsave(fs,ne)) return -1;
+      for(k=0;k<m;k++) exor(fs,EXSET(fs,ne),EXSET(fs,w->e[k]-fs->entries));
+      }
+    if(!trecnew(fs,j,TR_COMMIT)) return -1;
+    w->commitdep=fs->sdep;
     }
 
-  for(i=0;i<ne;i++) entries[i].upd=0; // all entry update effects now propagated into word updates
+  for(i=0;i<fs->neq;i++) fs->entries[fs->eq[i]].upd=0; // all entry update effects now propagated into word updates
+  fs->neq=0;
 //  DEB_F1 printf("settleents returns %d\n",f);fflush(stdout);
   return f;
   }
 
 // check updated word lists, rebuild feasible entry lists
-// returns -3 for aborted, 0 if no feasible letter lists affected, >0 otherwise
-static int settlewds(void) {
-  int f,i,j,k,l,m,mj,jmode;
+// returns -3 for aborted, -1 for out of memory, 0 if no feasible letter lists affected, >0 otherwise
+static int settlewds(struct fstate*fs) {
+  int f,g,i,j,k,l,m,mj,q,jmode;
   int*p;
   struct entry*e;
   struct word*w;
   ABM entfl[MXFL];
   DEB_F1 printf("settlewds()\n");
   f=0;
-  for(i=0;i<nw;i++) {
-    if(abort_flag) return -3;
-    w=words+i;
-    if(!w->upd) continue; // loop over updated word lists
+  for(q=0;q<fs->nwq;q++) { // loop over updated word lists
+    if(ABORTED) return -3;
+    i=fs->wq[q];
+    w=fs->words+i;
     if(ifamode==1&&i!=curword) continue;
     if(w->fe) continue;
          if(w->lp->emask&EM_JUM) jmode=1;
@@ -565,24 +1490,32 @@ static int settlewds(void) {
     l=w->flistlen;
 
     for(k=0;k<m;k++) entfl[k]=0;
-         if(jmode==0) for(j=0;j<l;j++) for(k=0;k<m;k++) entfl[k]|=ICCTOABM((int)lts[p[j]].s[k]); // find all feasible letters from word list
+         if(jmode==0) for(k=0;k<m;k++) entfl[k]=colabm(w->fcol+k*w->fcs,l); // find all feasible letters from word list
     else if(jmode==1) for(j=0;j<l;j++) {
       for(k=0;k<mj;k++) entfl[k]|=w->jflbm[j*mj+k]; // main work has been done in settleents()
       for(   ;k<m ;k++) entfl[k]|=ICCTOABM((int)lts[p[j]].s[k]);
       }
-    else if(jmode==2) for(j=0;j<l;j++) for(k=0;k<m;k++) entfl[k]|=w->sdata[j].flbm[k]; // main work has been done in settleents()
+    else if(jmode==2) for(j=0;j<l;j++) for(k=0;k<m;k++) entfl[k]|=SDFLBM(w,j)[k]; // main work has been done in settleents()
 
     DEB_F2 { printf("w=%d entfl: ",i); pabms(entfl,m,1); printf("\n"); }
-    for(j=0;j<m;j++) {
+    for(j=0,g=0;j<m;j++) {
       e=w->e[j]; // propagate from word to entry
       if(e->flbm&~entfl[j]) { // has this entry been changed by the additional constraint?
+        if(fs->ex) { // the entry now also depends on what determined this word's list
+          if(!g) {exclr(fs,fs->cw); wexpl(fs,w,fs->cw); g=1;}
+          if(exsave(fs,e-fs->entries)) return -1;
+          exor(fs,EXSET(fs,e-fs->entries),fs->cw);
+          }
+        if(esave(fs,e-fs->entries)) return -1;
         e->flbm&=entfl[j];
-        e->upd=1;f++; // flag that it will need updating
+        eupd(fs,e-fs->entries);f++; // flag that it will need updating
+        hupd(fs,e-fs->entries);
   //      printf("E%d %16llx\n",k,entries[k].flbm);fflush(stdout);
         }
       }
     }
-  for(i=0;i<nw;i++) words[i].upd=0; // all word list updates processed
+  for(q=0;q<fs->nwq;q++) fs->words[fs->wq[q]].upd=0; // all word list updates processed
+  fs->nwq=0;
   DEB_F1 {printf("settlewds returns %d\n",f);fflush(stdout);}
   return f;
   }
@@ -649,59 +1582,86 @@ DEB_F3 {       printf("  e%3d:",k); for(i=1;i<27;i++) printf("%7.1f",sc[k][i]);
 
 // calculate scores for spread entry
 static void sscores(struct word*w,int wn,double(*sc)[MAXICC+1]) {
-  struct sdata*sd;
+  double*ct,*ctd;
   struct light*l;
   int c,i,j,k,m,n;
 
   l=lts+w->flist[wn];
   m=w->nent;
   n=w->wlen;
-  sd=w->sdata+wn;
+  ct=SDCT(w,wn);
+  ctd=ct+n*m;
   memset(sc,0,m*(MAXICC+1)*sizeof(double));
   for(i=0;i<n;i++) {
     c=(int)l->s[i];
-    for(j=0;j<m;j++) sc[j][c]+=sd->ct[i][j];
+    for(j=0;j<m;j++) sc[j][c]+=ct[i*m+j];
     }
   // now do the spreading character as a special case: i=#chars to left of candidate '-'
-  for(j=0;j<m;j++) sc[j][ICC_DASH]+=sd->ctd[j];
+  for(j=0;j<m;j++) sc[j][ICC_DASH]+=ctd[j];
 DEB_F3 for(k=0;k<m;k++) {printf("  e%2d:",k); for(i=1;i<MAXICC+1;i++) {printf(" %5.1f",sc[k][i]); if(i==26||i==36) printf("  ");} printf("\n"); }
   }
 
 
-// calculate per-entry scores
+// flag all cached scores as needing recalculation
+static void scinit(struct fstate*fs) {int i;
+  for(i=0;i<nw;i++) fs->wdirty[i]=1;
+  for(i=0;i<ne;i++) fs->edirty[i]=1;
+  }
+
+// log10 of the best answer score among lights in the feasible list of word w, ignoring used ones if u is set
+static double wbestsc(struct fstate*fs,struct word*w,int u) {int j,k;
+  double f,g;
+
+  g=0;
+  for(j=0;j<w->flistlen;j++) {
+    if(u&&isused(w->flist[j])) continue;
+    k=lts[w->flist[j]].ans;
+    f=k<0?1.0:ansp[k]->score; // assume score=1 if a treatment light
+    if(f>g) g=f;
+    }
+  return g>0?log10(g):-DBL_MAX;
+  }
+
+// calculate per-entry scores: each word's contribution is recalculated only if its feasible list, its
+// jumble or spread data or (if afunique) the set of used lights has changed since it was last calculated,
+// and the score for an entry is recombined only if one of its words' contributions has been recalculated.
+// Contributions are multiplied together in the same order as if they were all recalculated.
 // returns -3 if aborted
-static int mkscores(void) {
-  int c,i,j,k,l,m,mj,jmode;
+static int mkscores(struct fstate*fs) {
+  int c,i,j,k,l,m,mj,jmode,u;
   int*p;
+  unsigned char*q;
   double f;
   struct word*w;
-  // following static to reduce stack use
-  static double sc[MXFL][MAXICC+1],tsc[MXFL][MAXICC+1]; // weighted count of number of words that put a given letter in a given place
+  struct entry*e;
+  double(*sc)[MAXICC+1],(*tsc)[MAXICC+1]=fs->scr->tsc; // weighted count of number of words that put a given letter in a given place
 
-  for(i=0;i<ne;i++) for(j=1;j<MAXICC+1;j++) entries[i].score[j]=1.0;
   for(i=0;i<nw;i++) {
-    if(abort_flag) return -3;
-    w=words+i;
+    if(ABORTED) return -3;
+    w=fs->words+i;
     if(w->fe) continue;
+    p=w->flist;
+    if(!p) continue;
          if(w->lp->emask&EM_JUM) jmode=1;
     else if(w->lp->emask&EM_SPR) jmode=2;
     else                         jmode=0;
+    u=afunique&&fs->wuf[i]; // list might contain used lights?
+    if(jmode==0&&u&&fs->wuep[i]!=fs->uep) fs->wdirty[i]=1;
+    if(!fs->wdirty[i]) continue;
     m=w->nent;
     mj=w->jlen;
-    p=w->flist;
     l=w->flistlen;
+    sc=fs->wsc+wsco[i];
     for(k=0;k<m;k++) for(j=1;j<MAXICC+1;j++) sc[k][j]=0.0;
-    if(!p) continue;
 
     if(jmode==0) { // normal case
       if(afunique&&w->commitdep>=0) {  // avoid zero score if we've committed
-        if(l==1) for(k=0;k<m;k++) sc[k][(int)lts[p[0]].s[k]]+=1.0;
+        if(l==1) for(k=0;k<m;k++) sc[k][w->fcol[k*w->fcs]]+=1.0;
         }
       else {
-        for(j=0;j<l;j++) if(!(afunique&&isused(p[j]))) { // for each remaining feasible word
-          if(lts[p[j]].ans<0) f=1;
-          else f=(double)ansp[lts[p[j]].ans]->score;
-          for(k=0;k<m;k++) sc[k][(int)lts[p[j]].s[k]]+=f; // add in its score to this cell's score
+        for(j=0;j<l;j++) if(!(u&&isused(p[j]))) { // for each remaining feasible word
+          f=w->fsc[j];
+          for(k=0,q=w->fcol+j;k<m;k++,q+=w->fcs) sc[k][*q]+=f; // add in its score to this cell's score
           }
         }
     } else if(jmode==1) { // jumble case
@@ -719,18 +1679,38 @@ static int mkscores(void) {
         }
       }
 
-    for(k=0;k<m;k++) for(j=1;j<MAXICC+1;j++) w->e[k]->score[j]*=sc[k][j];
+    if(fs->wbest) fs->wbest[i]=wbestsc(fs,w,jmode==0&&u&&w->commitdep<0);
+    fs->wdirty[i]=0;
+    fs->wuep[i]=fs->uep;
+    for(k=0;k<m;k++) fs->edirty[w->e[k]-fs->entries]=1;
     }
   for(i=0;i<ne;i++) {
-    f=-DBL_MAX; for(j=1;j<MAXICC+1;j++) f=MX(f,entries[i].score[j]);
-    entries[i].crux=f; // crux at an entry is the greatest score over all possible letters
+    if(!fs->edirty[i]) continue;
+    e=fs->entries+i;
+    for(j=1;j<MAXICC+1;j++) e->score[j]=1.0;
+    for(c=ewdsi[i];c<ewdsi[i+1];c++) { // combine contributions from each word in order
+      w=fs->words+ewds[c];
+      if(w->fe||!w->flist) continue;
+      sc=fs->wsc+wsco[ewds[c]]+ewdk[c];
+      for(j=1;j<MAXICC+1;j++) e->score[j]*=sc[0][j];
+      }
+    fs->edirty[i]=0;
+    f=-DBL_MAX; for(j=1;j<MAXICC+1;j++) f=MX(f,e->score[j]);
+    if(e->crux!=f) e->crux=f,hupd(fs,i); // crux at an entry is the greatest score over all possible letters
     }
   return 0;
   }
 
 
-// sort possible letters into order of decreasing favour with randomness r; write results to s in internal character code
-void getposs(struct entry*e,char*s,int r,int dash) {
+// random number in [0,0x7fff] from generator state *rs
+static int frand(unsigned int*rs) {
+  *rs=*rs*1103515245+12345;
+  return (int)((*rs>>16)&0x7fff);
+  }
+
+// sort possible letters into order of decreasing favour with randomness r, using random number generator state *rs;
+// write results to s in internal character code
+void getposs(struct entry*e,char*s,int r,int dash,unsigned int*rs) {
   int i,l,m,n,nicc;
   double j,k;
   DEB_F1 printf("getposs(%d)\n",(int)(e-entries));
@@ -747,120 +1727,224 @@ void getposs(struct entry*e,char*s,int r,int dash) {
   s[l]='\0';
   if(r==0) return;
   for(i=0;i<l;i++) { // randomise if necessary
-    m=i+rand()%(r*2+1); // candidate for swap: distance depends on randomisation level
+    m=i+frand(rs)%(r*2+1); // candidate for swap: distance depends on randomisation level
     if(m>=0&&m<l) n=s[i],s[i]=s[m],s[m]=n; // swap candidates
     }
   }
 
 // indent according to stack depth
-static void sdepsp(void) {int i; if(sdep<0) printf("<%d",sdep); for(i=0;i<sdep;i++) printf(" ");}
+static void sdepsp(struct fstate*fs) {int i; if(fs->sdep<0) printf("<%d",fs->sdep); for(i=0;i<fs->sdep;i++) printf(" ");}
 
-static void freestack() {int i;
+static void freestack(struct fstate*fs) {int i;
   for(i=0;i<=ne;i++) {
-    if(sposs     ) FREEX(sposs     [i]);
-    if(sflist    ) FREEX(sflist    [i]);
-    if(sjdata    ) FREEX(sjdata    [i]);
-    if(sjflbm    ) FREEX(sjflbm    [i]);
-    if(ssdata    ) FREEX(ssdata    [i]);
-    if(sflistlen ) FREEX(sflistlen [i]);
-    if(sentryfl  ) FREEX(sentryfl  [i]);
-    }
-  FREEX(sposs);
-  FREEX(spossp);
-  FREEX(sflist);
-  FREEX(sjdata);
-  FREEX(sjflbm);
-  FREEX(ssdata);
-  FREEX(sflistlen);
-  FREEX(sentryfl);
-  FREEX(sentry);
-  for(i=0;i<nw;i++) {
+    if(fs->sposs     ) FREEX(fs->sposs     [i]);
+    }
+  FREEX(fs->sposs);
+  FREEX(fs->spossp);
+  FREEX(fs->strailp);
+  FREEX(fs->sentry);
+  FREEX(fs->scr);
+  FREEX(fs->hp);
+  FREEX(fs->hpos);
+  FREEX(fs->efix);
+  fs->nhp=0;
+  FREEX(fs->wsc);
+  FREEX(fs->wdirty);
+  FREEX(fs->wuep);
+  FREEX(fs->edirty);
+  FREEX(fs->eq);
+  FREEX(fs->wq);
+  FREEX(fs->wl);
+  FREEX(fs->wmk);
+  FREEX(fs->wuf);
+  FREEX(fs->esv);
+  FREEX(fs->wsv);
+  FREEX(fs->jrep);
+  FREEX(fs->jmk);
+  fs->neq=fs->nwq=0;
+  FREEX(fs->ex);
+  FREEX(fs->exs);
+  FREEX(fs->scs);
+  FREEX(fs->cf);
+  FREEX(fs->cw);
+  FREEX(fs->ng);
+  fs->nng=fs->ngp=0;
+  FREEX(fs->ewt);
+  FREEX(fs->bfl);
+  FREEX(fs->wbest);
+  if(fs->trail) {free(fs->trail); fs->trail=0; ct_free++;}
+  fs->trailn=fs->traila=0;
+  if(fs==&fs0) for(i=0;i<nw;i++) { // per-word data belong to the main state: worker states only share them
     FREEX(words[i].jdata);
     FREEX(words[i].jflbm);
     FREEX(words[i].sdata);
+    FREEX(words[i].fsc);
+    words[i].fcol=0;
+    FREEX(words[i].fbs);
+    FREEX(words[i].bsi);
     }
   }
 
-static int allocstack() {int i;
-  freestack();
-  if(!(sposs     =calloc(ne+1,sizeof(char*         )))) return 1;
-  if(!(spossp    =calloc(ne+1,sizeof(int           )))) return 1;
-  if(!(sflist    =calloc(ne+1,sizeof(int**         )))) return 1;
-  if(!(sjdata    =calloc(ne+1,sizeof(struct jdata**)))) return 1;
-  if(!(sjflbm    =calloc(ne+1,sizeof(ABM**         )))) return 1;
-  if(!(ssdata    =calloc(ne+1,sizeof(struct sdata**)))) return 1;
-  if(!(sflistlen =calloc(ne+1,sizeof(int*          )))) return 1;
-  if(!(sentryfl  =calloc(ne+1,sizeof(ABM*          )))) return 1;
-  if(!(sentry    =calloc(ne+1,sizeof(int           )))) return 1;
+static int allocstack(struct fstate*fs) {int i;
+  freestack(fs);
+  if(!(fs->sposs     =calloc(ne+1,sizeof(char*         )))) return 1;
+  if(!(fs->spossp    =calloc(ne+1,sizeof(int           )))) return 1;
+  if(!(fs->strailp   =calloc(ne+1,sizeof(size_t        )))) return 1;
+  if(!(fs->sentry    =calloc(ne+1,sizeof(int           )))) return 1;
+  if(!(fs->scr       =malloc(sizeof(struct scratch)))) return 1;
+  if(!(fs->hp        =malloc((ne+1)*sizeof(int     )))) return 1;
+  if(!(fs->hpos      =malloc((ne+1)*sizeof(int     )))) return 1;
+  if(!(fs->efix      =malloc(ne+1                 ))) return 1;
+  if(!(fs->wsc       =malloc((wsco[nw]+1)*sizeof(double[MAXICC+1])))) return 1;
+  if(!(fs->wdirty    =malloc(nw+1                 ))) return 1;
+  if(!(fs->wuep      =calloc(nw+1,sizeof(unsigned int)))) return 1;
+  if(!(fs->edirty    =malloc(ne+1                 ))) return 1;
+  if(!(fs->eq        =malloc((ne+1)*sizeof(int     )))) return 1;
+  if(!(fs->wq        =malloc((nw+1)*sizeof(int     )))) return 1;
+  if(!(fs->wl        =malloc((nw+1)*sizeof(int     )))) return 1;
+  if(!(fs->wmk       =calloc(nw+1,1               ))) return 1;
+  if(!(fs->wuf       =calloc(nw+1,1               ))) return 1;
+  if(!(fs->esv       =calloc(ne+1,sizeof(unsigned int)))) return 1;
+  if(!(fs->wsv       =calloc(nw+1,sizeof(unsigned int)))) return 1;
+  if(filler_cbj) {
+    fs->exn=(ne+1+63)/64; // decision depths run from 1 to ne
+    if(!(fs->ex     =calloc((size_t)(ne+1+nw)*fs->exn,sizeof(uint64_t)))) return 1;
+    if(!(fs->exs    =calloc(ne+1+nw,sizeof(unsigned int)))) return 1;
+    if(!(fs->scs    =calloc((size_t)(ne+1)*fs->exn,sizeof(uint64_t)))) return 1;
+    if(!(fs->cf     =calloc(fs->exn,sizeof(uint64_t)))) return 1;
+    if(!(fs->cw     =calloc(fs->exn,sizeof(uint64_t)))) return 1;
+    if(filler_cbj>1&&!(fs->ng=malloc(NGMAX*sizeof(struct nogood)))) return 1;
+    }
+  fs->exl=EXNONE;
+  fs->tl=TRNONE;
+  fs->ser=fs->nser=0;
+  if(afrestart&&afrweights) {
+    if(!(fs->ewt    =malloc((ne+1)*sizeof(double  )))) return 1;
+    for(i=0;i<=ne;i++) fs->ewt[i]=1;
+    }
   for(i=0;i<=ne;i++) { // for each stack depth that can be reached
-    if(!(sposs     [i]=malloc(MAXICC+2                ))) return 1;
-    if(!(sflist    [i]=malloc(nw*sizeof(int*         )))) return 1;
-    if(!(sjdata    [i]=malloc(nw*sizeof(struct jdata*)))) return 1;
-    if(!(sjflbm    [i]=malloc(nw*sizeof(ABM*         )))) return 1;
-    if(!(ssdata    [i]=malloc(nw*sizeof(struct sdata*)))) return 1;
-    if(!(sflistlen [i]=malloc(nw*sizeof(int          )))) return 1;
-    if(!(sentryfl  [i]=malloc(ne*sizeof(ABM          )))) return 1;
+    if(!(fs->sposs     [i]=malloc(MAXICC+2                ))) return 1;
     }
   return 0;
   }
 
 // initialise state stacks
-static void state_init(void) {sdep=-1;filler_status=0;}
+static void state_init(struct fstate*fs) {fs->sdep=-1;filler_status=0;}
 
 // push stack
-static void state_push(void) {int i;
-  sdep++;
-  assert(sdep<=ne);
-  for(i=0;i<nw;i++) sflistlen[sdep][i]=-1;  // flag that flists need allocating
-  for(i=0;i<ne;i++) sentryfl[sdep][i]=entries[i].flbm; // feasible letter lists
+static void state_push(struct fstate*fs) {
+  fs->sdep++;
+  assert(fs->sdep<=ne);
+  fs->ser=++fs->nser; // entries and words need saving again before they are changed
+  fs->strailp[fs->sdep]=fs->trailn;
   }
 
 // undo effect of last deepening operation
-static void state_restore(void) {int i,j,l; struct word*w;
-  for(i=0;i<nw;i++) {
-    w=words+i;
-    if(w->commitdep>=sdep) { // word to uncommit?
+static void state_restore(struct fstate*fs) {int i,j,l; struct word*w; struct exrec*r; struct trec*q; char*t;
+  for(;fs->tl!=TRNONE&&fs->tl>=fs->strailp[fs->sdep];fs->tl=q->prev) { // undo changes made at this depth, latest first
+    q=(struct trec*)(fs->trail+fs->tl);
+    i=q->i;
+    if(q->l==TR_ENTRY) {
+      if(fs->entries[i].flbm!=q->flbm) fs->entries[i].flbm=q->flbm,hupd(fs,i);
+      continue;
+      }
+    w=fs->words+i;
+    if(q->l==TR_COMMIT) { // word to uncommit
       l=w->flistlen;
 DEB_F2 {
-      printf("sdep=%d flistlen=%d uncommitting word %d commitdep=%d:",sdep,w->flistlen,i,w->commitdep);
+      printf("sdep=%d flistlen=%d uncommitting word %d commitdep=%d:",fs->sdep,w->flistlen,i,w->commitdep);
       for(j=0;j<l;j++) {printf(" "); printICCs(lts[w->flist[j]].s);}
       printf("\n");
     }
       for(j=0;j<l;j++) setused(w->flist[j],0);
+      fs->uep++;
       w->commitdep=-1;
+      fs->wdirty[i]=1;
+      continue;
       }
-    if(sflistlen[sdep][i]!=-1&&w->flist!=0) { // word feasible list to free?
-      free(w->flist);
-      ct_free++;
-      w->flist=sflist[sdep][i];
-      w->flistlen=sflistlen[sdep][i];
-      if(w->jdata) {
-        free(w->jdata);
-        ct_free++;
-        w->jdata=sjdata[sdep][i];
-        }
-      if(w->jflbm) {
-        free(w->jflbm);
-        ct_free++;
-        w->jflbm=sjflbm[sdep][i];
-        }
-      if(w->sdata) {
-        free(w->sdata);
-        ct_free++;
-        w->sdata=ssdata[sdep][i];
-        }
+    l=q->l; // word feasible list to restore
+    t=fs->trail+fs->tl+TRAILRND(sizeof(struct trec));
+    if(w->fbs) memcpy(w->fbs,t,BSINB(w)*sizeof(uint64_t));
+    w->fbs=q->fbs;
+    if(w->jdata) {
+      memcpy(w->flist,t,l*sizeof(int));                t+=TRAILRND(l*sizeof(int));
+      memcpy(w->jdata,t,l*sizeof(struct jdata));       t+=TRAILRND(l*sizeof(struct jdata));
+      memcpy(w->jflbm,t,l*w->jlen*sizeof(ABM));
       }
+    if(w->sdata) {
+      memcpy(w->flist,t,l*sizeof(int));                t+=TRAILRND(l*sizeof(int));
+      memcpy(w->sdata,t,l*SDSZ(w));
+      }
+    w->flistlen=l; // lights removed at this depth are still there after the end of the list
+    fs->wdirty[i]=1;
+    fs->wuf[i]=1; // may have been filtered for lights still in use
+    }
+  for(;fs->exl!=EXNONE&&fs->exl>=fs->strailp[fs->sdep];fs->exl=r->prev) { // restore sets saved at this depth, latest first
+    r=(struct exrec*)(fs->trail+fs->exl);
+    memcpy(EXSET(fs,r->i),r+1,fs->exn*sizeof(uint64_t));
     }
-  for(i=0;i<ne;i++) entries[i].flbm=sentryfl[sdep][i];
+  fs->ser=++fs->nser; // anything changed from now on needs saving again
+  fs->trailn=fs->strailp[fs->sdep];
   }
 
 // pop stack
-static void state_pop(void) {assert(sdep>=0);state_restore();sdep--;}
+static void state_pop(struct fstate*fs) {assert(fs->sdep>=0);state_restore(fs);fs->sdep--;}
 
 // clear state stacks and free allocated memory
-static void state_finit(void) {
-  while(sdep>=0) state_pop();
-  freestack();
+static void state_finit(struct fstate*fs) {
+  while(fs->sdep>=0) state_pop(fs);
+  freestack(fs);
+  }
+
+// PARALLEL LOOPS
+
+// Setting up for the search and reading dictionaries are shared out over several threads in the same way
+// for each job: the calling thread and up to nt-1 helpers take indices in turn until all have been done.
+// The filler uses filler_threads threads; dictionaries are read using one per processor.
+
+struct ploop { // one call of pforeach(); calls may be made from several threads at once
+  GMutex*m;                      // protects the following
+  int i,n;                       // next index to take, and end of range
+  void (*f)(int,void*);          // what to do with each
+  void*a;
+  };
+
+static gpointer plworker(gpointer d) {int i; struct ploop*p;
+  p=(struct ploop*)d;
+  for(;;) {
+    g_mutex_lock(p->m);
+    i=p->i<p->n?p->i++:-1;
+    g_mutex_unlock(p->m);
+    if(i<0) return 0;
+    (*p->f)(i,p->a);
+    }
+  }
+
+// call f(i,a) for 0<=i<n, using up to nt threads; the calls may be made in any order
+// and f must not change anything that another call uses
+void pforeach(int n,int nt,void (*f)(int,void*),void*a) {
+  GThread*th[MAXFTHREADS];
+  struct ploop p;
+  int i,j,m;
+
+  m=nt<n?nt:n;
+  if(m>MAXFTHREADS) m=MAXFTHREADS;
+  if(m<=1) {for(i=0;i<n;i++) (*f)(i,a); return;}
+  p.m=g_mutex_new();
+  p.i=0,p.n=n,p.f=f,p.a=a;
+  for(i=0;i<m-1;i++) {
+    th[i]=g_thread_create_full(&plworker,&p,0,1,1,G_THREAD_PRIORITY_LOW,0);
+    if(!th[i]) break; // carry on with the threads we have
+    }
+  plworker(&p);
+  for(j=0;j<i;j++) g_thread_join(th[j]);
+  g_mutex_free(p.m);
+  }
+
+// set up the per-word data derived from the initial feasible list of word i; *(int*)a is set on out of memory
+static void initword(int i,void*a) {
+  if(!words[i].flist) return; // list not built
+  if(initjdata(i)||initsdata(i)||initcols(words+i)||initbsi(i)) g_atomic_int_set((int*)a,1);
   }
 
 // build initial feasible lists, calling plug-in as necessary
@@ -872,6 +1956,10 @@ static int buildlists(void) {int u,i,j;
     FREEX(words[i].jdata);
     FREEX(words[i].jflbm);
     FREEX(words[i].sdata);
+    FREEX(words[i].fsc);
+    words[i].fcol=0;
+    FREEX(words[i].fbs);
+    FREEX(words[i].bsi);
     lightx=words[i].gx0;
     lighty=words[i].gy0;
     lightdir=words[i].ldir;
@@ -882,8 +1970,6 @@ static int buildlists(void) {int u,i,j;
     if(fillmode>0||ifamode==2||(ifamode==1&&i==curword)) { // only build the lists we need
       u=getinitflist(&words[i].flist,&words[i].flistlen,words[i].lp,words[i].wlen);
       if(u) {filler_status=-3;return 0;}
-      if(initjdata(i)) {filler_status=-3;return 0;}
-      if(initsdata(i)) {filler_status=-3;return 0;}
       }
     if(abort_flag) {
       DEB_F1 printf("aborted while building word lists\n");
@@ -893,82 +1979,595 @@ static int buildlists(void) {int u,i,j;
     if(words[i].lp->ten) clueorderindex++;
     }
   DEB_F1 printf("\n");
+  u=0;
+  pforeach(nw,filler_threads,initword,&u); // the rest of the set-up for each word is independent of the others
+  if(u) {filler_status=-3;return 0;}
   if(postgetinitflist()) {filler_status=-4;return 1;}
-  FREEX(aused);
-  FREEX(lused);
-  aused=(unsigned char*)calloc(atotal+NMSG,sizeof(unsigned char)); // enough for "msgword" answers too
-  if(aused==NULL) {filler_status=-3;return 0;}
-  lused=(unsigned char*)calloc(ultotal,sizeof(unsigned char));
-  if(lused==NULL) {filler_status=-3;return 0;}
+  if(mkuwds()) {filler_status=-3;return 0;}
+  if(mkjcls()) {filler_status=-3;return 0;}
+  FREEX(fs0.aused);
+  FREEX(fs0.lused);
+  fs0.aused=(unsigned char*)calloc(atotal+NMSG,sizeof(unsigned char)); // enough for "msgword" answers too
+  if(fs0.aused==NULL) {filler_status=-3;return 0;}
+  fs0.lused=(unsigned char*)calloc(ultotal,sizeof(unsigned char));
+  if(fs0.lused==NULL) {filler_status=-3;return 0;}
+  return 0;
+  }
+
+// propagate updates to fixpoint ("unit propagation"); returns
+// -5: told to abort
+// -2: infeasible
+// -1: out of memory
+//  0: settled
+static int settle1(struct fstate*fs) {int f;
+  do {
+    fs->st.nset++;
+    if(ABORTED) {DEB_F1 printf("aborting...\n"); return -5;}
+    f=settleents(fs); // rescan entries
+    if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;}
+    if(f<0) return f; // out of memory, or proved impossible
+    if(f>0) {
+      f=settlewds(fs); // rescan words
+      if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;}
+      if(f<0) return f; // out of memory
+      }
+    if(f==0&&fs->nng) { // settled: do any learnt nogoods now rule out letters?
+      f=ngcheck(fs);
+      if(f<0) return f; // out of memory, or proved impossible
+      }
+    } while(f); // need to iterate until everything settles down
   return 0;
   }
 
-// Main search routine. Returns
+// settle1() with timing if wanted
+static int settle(struct fstate*fs) {int f;
+  gint64 t;
+  if(!filler_timing) return settle1(fs);
+  t=g_get_monotonic_time();
+  f=settle1(fs);
+  fs->st.tset+=g_get_monotonic_time()-t;
+  return f;
+  }
+
+// time and decision limits: see BUDGETS below
+static int bon=0;             // checking limits?
+static gint64 bstart;         // time the filler started
+static ABM*bpfl=0;            // most complete partial assignment so far
+static int bpfn;              // ... and its number of determined entries
+
+static void donate(struct fstate*fs);
+static int overbudget(struct fstate*fs);
+static void partial(struct fstate*fs);
+static void bestfound(struct fstate*fs,double b);
+static int solfound(struct fstate*fs);
+
+// Main search routine. If resume is set the search continues from the possibilities
+// already set up at the current depth. Returns
+// -6: reached time or decision limit
 // -5: told to abort
 // -1: out of memory
 // -2: out of stack
 //  1: all done, no result found
 //  2: all done, result found or only doing BG fill anyway
-static int search() {
-  int e,f;
+static int search(struct fstate*fs,int resume) {
+  int d,e,f,i;
   unsigned char c;
   clock_t ct1;
+  gint64 t;
+  double b=0;
 
+  if(resume) goto nextposs;
   if(fillmode==0&&ifamode==1) {
-    f=settleents();
+    f=settleents(fs);
     if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;}
-    f=settlewds();
+    f=settlewds(fs);
     if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;}
-    f=mkscores();
+    f=mkscores(fs);
     if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;}
     return 2;
     }
 
 // Initially entry flbms are not consistent with word lists or vice versa. So we
 // need to make sure we call both settlewds() and settleents() before proceeding.
-  if(settlewds()==-3) {DEB_F1 printf("aborting...\n"); return -5;};
-resettle: // "unit propagation"
-  do {
-    if(abort_flag) {DEB_F1 printf("aborting...\n"); return -5;}
-    f=settleents(); // rescan entries
-    if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;}
-    if(f==0) break;
-    if(f==-1) return -1; // out of memory: abort
-    if(f==-2) goto backtrack; // proved impossible
-    f=settlewds(); // rescan words
-    if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;}
-    } while(f); // need to iterate until everything settles down
-  f=mkscores();
+  f=settlewds(fs);
+  if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;};
+  if(f<0) return f; // out of memory
+resettle:
+  f=settle(fs);
+  if(f==-2) {fs->nfail++; goto backtrack;} // proved impossible
+  if(f<0) return f; // out of memory or aborted
+  if(bon) partial(fs);
+  if(filler_timing) {
+    t=g_get_monotonic_time();
+    f=mkscores(fs);
+    fs->st.tsc+=g_get_monotonic_time()-t;
+  } else f=mkscores(fs);
   if(f==-3) {DEB_F1 printf("aborting...\n"); return -5;}
   if(fillmode==0||fillmode==3) return 2; // only doing BG/preexport fill? stop after first settle
-  DEB_F2 pstate(1);
+  DEB_F2 pstate(fs,1);
+  if(fs->bfl) { // looking for the best fill: can this subtree improve on it?
+    for(i=0,b=0;i<nw;i++) b+=fs->wbest[i]; // optimistic bound
+    if(!(b>fs->bsc+1e-9)) {exfailall(fs); goto backtrack;}
+    if(fs->bsc>-DBL_MAX&&g_get_monotonic_time()-fs->bt0>afbest*1e6) {fs->btout=1; return 1;} // out of time
+    }
 
 // go one level deeper in search tree
-  DEB_F2 { int w; for(w=0;w<nw;w++) printf("[w%d: %d]",w,words[w].flistlen); printf("\n"); }
-  e=findcritent(); // find the most critical entry, over whose possible letters we will iterate
-  if(e==-1) return 2; // all done, result found
-  getposs(entries+e,sposs[sdep],afrandom,1); // find feasible letter list in descending order of score
-  DEB_F1 { printf("D%3d ",sdep);sdepsp();printf("crit E%d ",e);printICCs(sposs[sdep]);printf("\n");fflush(stdout); }
-  sentry[sdep]=e;
-  spossp[sdep]=0; // start on most likely possibility
+  DEB_F2 { int w; for(w=0;w<nw;w++) printf("[w%d: %d]",w,fs->words[w].flistlen); printf("\n"); }
+  e=findcritent(fs); // find the most critical entry, over whose possible letters we will iterate
+  if(e==-1) {
+    if(fs->enm) { // counting fills: carry on looking unless we have enough
+      if(solfound(fs)) return 2;
+      exfailall(fs);
+      goto backtrack;
+      }
+    if(!fs->bfl) return 2; // all done, result found
+    bestfound(fs,b); // an improvement: note it and carry on looking
+    exfailall(fs);
+    goto backtrack;
+    }
+  getposs(fs->entries+e,fs->sposs[fs->sdep],fs->st.nrst?MX(afrandom,1):afrandom,1,&fs->rs); // find feasible letter list in descending order of score
+  DEB_F1 { printf("D%3d ",fs->sdep);sdepsp(fs);printf("crit E%d ",e);printICCs(fs->sposs[fs->sdep]);printf("\n");fflush(stdout); }
+  fs->sentry[fs->sdep]=e;
+  fs->spossp[fs->sdep]=0; // start on most likely possibility
+  exnode(fs,e);
 
 // try one possibility at the current critical entry
 nextposs:
-  e=sentry[sdep];
-  if(sposs[sdep][spossp[sdep]]=='\0') goto backtrack; // none left: backtrack
-  c=sposs[sdep][spossp[sdep]++]; // get letter to try
-DEB_F1 {  printf("D%3d ",sdep);sdepsp();printf("trying E%d=%s\n",e,icctoutf8[(int)c]);fflush(stdout); }
-  if(sdep==ne) return -2; // out of stack space (should never happen)
-  state_push();
-  entries[e].upd=1;
-  entries[e].flbm=ICCTOABM((int)c); // fix feasible list
-  ct1=clock(); if(ct1-ct0>CLOCKS_PER_SEC*3||ct1<ct0) {progress();ct0=clock();} // update display every three seconds or so
+  if(pidle>pnq) donate(fs); // another worker is idle?
+  e=fs->sentry[fs->sdep];
+  if(fs->sposs[fs->sdep][fs->spossp[fs->sdep]]=='\0') { // none left: backtrack
+    if(fs->ex) { // this depth fails with the conflict set it has collected
+      memcpy(fs->cf,fs->scs+(size_t)fs->sdep*fs->exn,fs->exn*sizeof(uint64_t));
+      nglearn(fs);
+      }
+    goto backtrack;
+    }
+  if(bon&&overbudget(fs)) return -6;
+  c=fs->sposs[fs->sdep][fs->spossp[fs->sdep]++]; // get letter to try
+DEB_F1 {  printf("D%3d ",fs->sdep);sdepsp(fs);printf("trying E%d=%s\n",e,icctoutf8[(int)c]);fflush(stdout); }
+  if(fs->sdep==ne) return -2; // out of stack space (should never happen)
+  state_push(fs);
+  fs->st.nodes++;
+  fs->st.sdsum+=fs->sdep;
+  if(fs->sdep>fs->st.sdmax) fs->st.sdmax=fs->sdep;
+  eupd(fs,e);
+  if(esave(fs,e)) return -1; // out of memory
+  fs->entries[e].flbm=ICCTOABM((int)c); // fix feasible list
+  hupd(fs,e);
+  if(exdecide(fs,e)) return -1; // out of memory
+  if(fs->prog) {
+    ct1=clock(); if(ct1-fs->ct0>CLOCKS_PER_SEC/5||ct1<fs->ct0) {progress(fs);fs->ct0=ct1;} // publish progress five times a second or so
+    }
   goto resettle; // update internal data from new entry
 
 backtrack:
-  state_pop();
-  if(sdep!=-1) goto nextposs;
-  return 1; // all done, no solution found
+  if(fs->sdep==fs->bdep) return 1; // subtree exhausted
+  d=fs->sdep; // depth of the decision that failed
+  state_pop(fs);
+  fs->st.nbt++;
+  if(fs->sdep==-1) return 1; // all done, no solution found
+  if(fs->ex) {
+    if(!EXTST(fs->cf,d)) {fs->st.nbj++; goto backtrack;} // decision played no part in the failure, so nor can the alternatives to it: jump back
+    EXBIC(fs->cf,d);
+    exor(fs,fs->scs+(size_t)fs->sdep*fs->exn,fs->cf);
+    }
+  if(fs->rlim&&fs->nfail>fs->rlim) goto restart;
+  goto nextposs;
+
+restart:
+  while(fs->sdep>0) state_pop(fs); // back to root
+  fs->st.nrst++;
+  fs->nfail=0;
+  fs->rlim=rlimit(fs->st.nrst);
+  DEB_F1 {printf("restart %lu: next after %lu failures\n",fs->st.nrst,fs->rlim);fflush(stdout);}
+  goto resettle;
+  }
+
+// PARALLEL SEARCH
+
+// The search tree below the root is shared out among filler_threads workers, each with its own copy of
+// the word and entry state as it stands after the initial settle. A worker that is exploring a subtree
+// gives away the untried possibilities at its shallowest open level whenever another worker is idle. A
+// task is described by the path of entry assignments from the root, which the receiving worker replays
+// to reconstruct the state. The first worker to complete a fill wins and the others are stopped.
+// In portfolio mode (filler_portfolio>1) no work is shared: instead each worker searches the whole tree
+// independently using its own random number generator seed and, optionally, its own variable ordering
+// heuristic, and again the first to complete a fill wins. When counting fills the portfolio workers share
+// the tree as above instead, and the search only finishes when it is exhausted or enough fills are found.
+
+// add the statistics from a worker into a
+static void addstats(struct fstats*a,struct fstats*b) {
+  a->nodes+=b->nodes;
+  a->nbt  +=b->nbt;
+  a->nbj  +=b->nbj;
+  a->nngl +=b->nngl;
+  a->nrst +=b->nrst;
+  a->nset +=b->nset;
+  a->nscan+=b->nscan;
+  a->sdsum+=b->sdsum;
+  a->sdmax =MX(a->sdmax,b->sdmax);
+  a->tset +=b->tset;
+  a->tsc  +=b->tsc;
+  }
+
+// hand the untried possibilities at the shallowest open level over to an idle worker
+static void donate(struct fstate*fs) {
+  int d,i,k;
+  struct ptask*t;
+
+  for(d=0;d<=fs->sdep;d++) {
+    k=fs->spossp[d]+(d==fs->sdep); // at current depth keep the next possibility for ourselves
+    if(fs->sposs[d][fs->spossp[d]]&&fs->sposs[d][k]) break;
+    }
+  if(d>fs->sdep) return; // nothing worth giving away
+  t=(struct ptask*)malloc(sizeof(struct ptask)+(d+1)*sizeof(int)+d);
+  if(!t) return;
+  t->d=d;
+  t->pe=(int*)(t+1);
+  t->pc=(char*)(t->pe+d+1);
+  for(i=0;i<d;i++) t->pe[i]=fs->sentry[i],t->pc[i]=fs->sposs[i][fs->spossp[i]-1]; // path from root
+  t->pe[d]=fs->sentry[d];
+  strcpy(t->poss,fs->sposs[d]+k);
+  g_mutex_lock(pmutex);
+  if(pstop||pidle<=pnq) {g_mutex_unlock(pmutex); free(t); return;} // no longer needed
+  fs->sposs[d][k]='\0'; // not ours any more
+  extaint(fs,d);
+  t->next=ptaskq;
+  ptaskq=t;
+  pnq++;
+  g_cond_signal(pcond);
+  g_mutex_unlock(pmutex);
+  DEB_F1 {printf("donated task at depth %d: ",d);printICCs(t->poss);printf("\n");fflush(stdout);}
+  }
+
+// explore the subtree described by task t; returns as search()
+static int runtask(struct fstate*fs,struct ptask*t) {
+  int e,f,i;
+
+  for(i=0;i<t->d;i++) { // replay path from root
+    e=t->pe[i];
+    fs->sentry[fs->sdep]=e;
+    fs->sposs[fs->sdep][0]=t->pc[i];
+    fs->sposs[fs->sdep][1]='\0';
+    fs->spossp[fs->sdep]=1; // nothing else to try at this level
+    extaint(fs,fs->sdep);
+    state_push(fs);
+    eupd(fs,e);
+    if(esave(fs,e)) {f=-1; goto ex0;}
+    fs->entries[e].flbm=ICCTOABM((int)t->pc[i]);
+    hupd(fs,e);
+    if(exdecide(fs,t->pe[i])) {f=-1; goto ex0;}
+    f=settle(fs);
+    if(f==-2) {f=1; goto ex0;} // cannot happen as the donor got here
+    if(f<0) goto ex0;
+    }
+  fs->sentry[fs->sdep]=t->pe[i];
+  strcpy(fs->sposs[fs->sdep],t->poss);
+  fs->spossp[fs->sdep]=0;
+  extaint(fs,fs->sdep);
+  f=search(fs,1);
+  if(f==2) return f; // leave winning state for caller
+ex0:
+  while(fs->sdep>fs->bdep) state_pop(fs); // back to root
+  return f;
+  }
+
+static gpointer pworker(gpointer data) {
+  int e,f;
+  struct fstate*fs=data;
+  struct ptask*t;
+
+  if(pfmode) { // independent search of the whole tree
+    e=findcritent(fs);
+    getposs(fs->entries+e,fs->sposs[0],afrandom,1,&fs->rs);
+    fs->sentry[0]=e;
+    fs->spossp[0]=0;
+    exnode(fs,e);
+    rinit(fs);
+    f=search(fs,1);
+    goto ex0;
+    }
+  for(;;) {
+    g_mutex_lock(pmutex);
+    pidle++;
+    for(;;) {
+      if(pstop) {g_mutex_unlock(pmutex); return 0;}
+      if(ptaskq) break;
+      if(pidle==pn) { // everyone is idle and there is nothing left to do: no fill
+        pstop=1;
+        pstatus=1;
+        g_cond_broadcast(pcond);
+        continue;
+        }
+      g_cond_wait(pcond,pmutex);
+      }
+    t=ptaskq;
+    ptaskq=t->next;
+    pnq--;
+    pidle--;
+    g_mutex_unlock(pmutex);
+    f=runtask(fs,t);
+    free(t);
+    if(f!=1) break; // fill found, or error
+    }
+ex0:
+  g_mutex_lock(pmutex);
+  if(!pstop) {
+    pstop=1;
+    pstatus=f;
+    if(f==2) { // we are the winner
+      for(e=0;e<ne;e++) pfl[e]=fs->entries[e].flbm;
+      pwin=fs;
+      }
+    }
+  g_cond_broadcast(pcond);
+  g_mutex_unlock(pmutex);
+  return 0;
+  }
+
+// copy n bytes at p to newly allocated memory; sets *f if out of memory
+static void*pdup(void*p,size_t n,int*f) {
+  void*q;
+
+  if(!p) return 0;
+  q=malloc(n?n:1);
+  if(!q) {*f=1; return 0;}
+  memcpy(q,p,n);
+  return q;
+  }
+
+// make a copy of the main filler state at the root of the search for a worker; returns 0 on out of memory
+static struct fstate*pfsnew(void) {
+  int f,i,j,l;
+  struct fstate*fs;
+  struct word*w;
+
+  fs=(struct fstate*)calloc(1,sizeof(struct fstate));
+  if(!fs) return 0;
+  fs->words=(struct word*)calloc(nw,sizeof(struct word)); // zeroed so that pfsfree() can tell what we have allocated
+  fs->entries=(struct entry*)malloc(ne*sizeof(struct entry));
+  fs->aused=(unsigned char*)malloc(atotal+NMSG);
+  fs->lused=(unsigned char*)malloc(ultotal);
+  if(!fs->words||!fs->entries||!fs->aused||!fs->lused) return fs;
+  memcpy(fs->words,words,nw*sizeof(struct word));
+  memcpy(fs->entries,entries,ne*sizeof(struct entry));
+  for(i=0;i<nw;i++) for(j=0;j<words[i].nent;j++) fs->words[i].e[j]=fs->entries+(words[i].e[j]-entries); // point to our own entries
+  for(i=0,f=0;i<nw;i++) { // feasible lists and associated data are narrowed in place, so we need our own copies
+    w=fs->words+i;
+    l=words[i].flistlen;
+    w->flist=pdup(words[i].flist,l*sizeof(int),&f);
+    w->fbs  =pdup(words[i].fbs,BSINB(w)*sizeof(uint64_t),&f);
+    w->jdata=pdup(words[i].jdata,l*sizeof(struct jdata),&f);
+    w->jflbm=pdup(words[i].jflbm,l*w->jlen*sizeof(ABM),&f);
+    w->sdata=pdup(words[i].sdata,l*SDSZ(w),&f);
+    if(initcols(w)) f=1;
+    }
+  if(f) return fs;
+  memcpy(fs->aused,fs0.aused,atotal+NMSG);
+  memcpy(fs->lused,fs0.lused,ultotal);
+  fs->sdep=-1;
+  if(allocstack(fs)) return fs;
+  memcpy(fs->wuf,fs0.wuf,nw);
+  for(i=0;i<ne;i++) if(fs->entries[i].upd) fs->eq[fs->neq++]=i; // copy update queues
+  for(i=0;i<nw;i++) if(fs->words[i].upd) fs->wq[fs->nwq++]=i;
+  fs->heur=fs0.heur;
+  hbuild(fs);
+  scinit(fs);
+  state_push(fs); // depth 0 holds the root, which we share with the main state and never pop
+  fs->bdep=0;
+  return fs;
+  }
+
+static void pfsfree(struct fstate*fs) {
+  int i;
+
+  if(!fs) return;
+  if(fs->sposs) while(fs->sdep>fs->bdep) state_pop(fs);
+  freestack(fs);
+  if(fs->words) for(i=0;i<nw;i++) {
+    FREEX(fs->words[i].flist);
+    FREEX(fs->words[i].fbs);
+    FREEX(fs->words[i].jdata);
+    FREEX(fs->words[i].jflbm);
+    FREEX(fs->words[i].sdata);
+    FREEX(fs->words[i].fsc);
+    }
+  FREEX(fs->words);
+  FREEX(fs->entries);
+  FREEX(fs->aused);
+  FREEX(fs->lused);
+  free(fs);
+  }
+
+// search using filler_threads workers, or filler_portfolio independent searches; returns as search()
+static int psearch(struct fstate*fs) {
+  int e,f,i,n;
+  struct ptask*t;
+  struct fstate*pfs[MAXFTHREADS]={0};
+  GThread*pth[MAXFTHREADS]={0};
+
+  f=settlewds(fs); // settle root as in search()
+  if(f==-3) return -5;
+  if(f<0) return f;
+  f=settle(fs);
+  if(f==-2) {state_pop(fs); return 1;}
+  if(f<0) return f;
+  if(mkscores(fs)==-3) return -5;
+  e=findcritent(fs);
+  if(e==-1) { // nothing to search
+    if(fs->enm) solfound(fs);
+    return 2;
+    }
+  n=filler_portfolio>1?filler_portfolio:filler_threads;
+  if(n>MAXFTHREADS) n=MAXFTHREADS;
+  pfmode=filler_portfolio>1&&!fs->enm;
+  pfl=(ABM*)malloc(ne*sizeof(ABM));
+  if(!pfl) return -1;
+  if(!pfmode) {
+    t=(struct ptask*)malloc(sizeof(struct ptask)+sizeof(int));
+    if(!t) {FREEX(pfl); return -1;}
+    t->next=0;
+    t->d=0;
+    t->pe=(int*)(t+1);
+    t->pe[0]=e;
+    getposs(fs->entries+e,t->poss,afrandom,1,&fs->rs);
+    ptaskq=t; // the whole tree as one task to start with
+    pnq=1;
+    }
+  pidle=0;
+  pwin=0;
+  pstop=0;
+  pstatus=1;
+  if(!pmutex) pmutex=g_mutex_new();
+  if(!pcond) pcond=g_cond_new();
+  f=0;
+  for(i=0;i<n;i++) {
+    pfs[i]=pfsnew();
+    if(!pfs[i]||!pfs[i]->sposs) {f=-1; break;}
+    pfs[i]->rs=pfs[i]->seed=fs->seed+i; // the first portfolio member repeats the serial search
+    pfs[i]->heur=(pfmode&&filler_pfheur)?(fs->heur+i)%2:fs->heur;
+    pfs[i]->enm=fs->enm;
+    if(pfs[i]->heur!=fs->heur) hbuild(pfs[i]);
+    }
+  if(f==0) {
+    pn=n;
+    pfs[0]->prog=1;
+    pfs[0]->ct0=fs->ct0;
+    for(i=0;i<n;i++) {
+      pth[i]=g_thread_create_full(&pworker,pfs[i],0,1,1,G_THREAD_PRIORITY_LOW,0);
+      if(!pth[i]) break;
+      }
+    if(i<n) { // could not start all threads: stop the ones we did start
+      g_mutex_lock(pmutex);
+      pstop=1;
+      pstatus=-1;
+      g_cond_broadcast(pcond);
+      g_mutex_unlock(pmutex);
+      }
+    for(i=0;i<n;i++) if(pth[i]) g_thread_join(pth[i]);
+    f=pstatus;
+    if(f==2) {
+      filler_wseed=pwin->seed;
+      filler_wheur=pwin->heur;
+      DEB_F0 printf("fill found with filler seed 0x%08x heuristic %d\n",filler_wseed,filler_wheur);
+      }
+    }
+  for(i=0;i<n;i++) if(pfs[i]) addstats(&fs->st,&pfs[i]->st);
+  for(i=0;i<n;i++) pfsfree(pfs[i]);
+  while(ptaskq) t=ptaskq,ptaskq=t->next,free(t);
+  pnq=0;
+  pidle=0;
+  pstop=0;
+  if(abort_flag) f=-5;
+  if(f==2) { // rebuild winning fill in main state
+    fs->enm=0;
+    bon=0;
+    fs->sentry[fs->sdep]=0;
+    fs->sposs[fs->sdep][0]='\0';
+    fs->spossp[fs->sdep]=0;
+    state_push(fs);
+    for(i=0;i<ne;i++) if(fs->entries[i].flbm!=pfl[i]) { // words already committed must not be revisited
+      if(esave(fs,i)) break;
+      fs->entries[i].flbm=pfl[i],eupd(fs,i),hupd(fs,i);
+      }
+    f=i<ne?-1:search(fs,0);
+    }
+  FREEX(pfl);
+  DEB_F0 printf("parallel search with %d threads returns %d\n",n,f);
+  return f;
+  }
+
+// a fill has been found while counting them; returns !=0 if that is enough
+static int solfound(struct fstate*fs) {int f;
+  if(fs!=&fs0) g_mutex_lock(pmutex); // parallel worker
+  f=filler_enumlim&&filler_nsol>=filler_enumlim; // another worker has already found enough?
+  if(!f) {
+    filler_nsol++;
+    if(filler_enum==2) dumpsol(fs->words,filler_nsol);
+    f=filler_enumlim&&filler_nsol>=filler_enumlim;
+    }
+  if(fs!=&fs0) g_mutex_unlock(pmutex);
+  return f;
+  }
+
+// BUDGETS
+
+// With filler_tlimit or filler_nlimit set, a fill stops with status -6 once the wall-clock time since the
+// filler started or the number of decisions made reaches the limit; each parallel worker counts its own
+// decisions. Meanwhile the most complete partial assignment reached, i.e., the settled state with the most
+// entries determined, is kept in bpfl, and searchdone() offers it as hints in place of a fill.
+
+// have we reached a limit?
+static int overbudget(struct fstate*fs) {
+  if(filler_nlimit&&fs->st.nodes>=filler_nlimit) {filler_limhit=2; return 1;}
+  if(filler_tlimit>0&&g_get_monotonic_time()-bstart>filler_tlimit*1e6) {filler_limhit=1; return 1;}
+  return 0;
+  }
+
+// note a settled state if it is more complete than any so far
+static void partial(struct fstate*fs) {int i,n;
+  n=fs->nfix; // kept up to date by hupd()
+  if(n<=bpfn) return;
+  if(fs!=&fs0) g_mutex_lock(pmutex); // parallel worker
+  if(n>bpfn) {
+    for(i=0;i<ne;i++) bpfl[i]=fs->entries[i].flbm;
+    bpfn=n;
+    }
+  if(fs!=&fs0) g_mutex_unlock(pmutex);
+  }
+
+// BEST FILL
+
+// With afbest set, search() does not stop at the first fill but carries on looking for fills with a greater
+// total score, summing log10 of the answer score of the best light remaining in each word's feasible list.
+// That sum is also an optimistic bound for the subtree below each node, which is pruned if it cannot beat
+// the best fill so far. Once a fill has been found the search stops after afbest seconds of wall-clock
+// time, as the limits in BUDGETS are measured, and the best fill is then rebuilt in the main state. This
+// is always a serial search.
+
+// fill with total score b found
+static void bestfound(struct fstate*fs,double b) {int i;
+  for(i=0;i<ne;i++) fs->bfl[i]=fs->entries[i].flbm;
+  fs->bsc=b;
+  DEB_F0 printf("best fill so far: score %g after %.2fs\n",b,(g_get_monotonic_time()-fs->bt0)*1e-6);
+  if(!usegui) fprintf(stderr,"Improved fill: score %.2f after %.1fs\n",b,(g_get_monotonic_time()-fs->bt0)*1e-6);
+  if(fs->prog) progress(fs),fs->ct0=clock(); // show it
+  }
+
+// search for the best fill; returns as search()
+static int bestsearch(struct fstate*fs) {
+  int f,i;
+
+  fs->bfl=(ABM*)malloc(ne*sizeof(ABM));
+  fs->wbest=(double*)calloc(nw+1,sizeof(double));
+  if(!fs->bfl||!fs->wbest) return -1;
+  fs->bsc=-DBL_MAX;
+  fs->btout=0;
+  fs->bt0=g_get_monotonic_time();
+  f=search(fs,0);
+  if(f==-6&&fs->bsc>-DBL_MAX) f=1,fs->btout=1; // reached a limit: make do with the best fill so far
+  if(f!=1||fs->bsc==-DBL_MAX) return f; // error, or no fill at all
+  bon=0; // no limits while rebuilding it
+  filler_bestsc=fs->bsc;
+  filler_bestopt=!fs->btout;
+  DEB_F0 printf("best fill score %g%s\n",fs->bsc,fs->btout?"":" (optimal)");
+  while(fs->sdep>0) state_pop(fs); // rebuild best fill in main state
+  if(fs->sdep==0) {
+    fs->sentry[fs->sdep]=0;
+    fs->sposs[fs->sdep][0]='\0';
+    fs->spossp[fs->sdep]=0;
+    }
+  state_push(fs);
+  for(i=0;i<ne;i++) if(fs->entries[i].flbm!=fs->bfl[i]) {
+    if(esave(fs,i)) break;
+    fs->entries[i].flbm=fs->bfl[i],eupd(fs,i),hupd(fs,i);
+    }
+  FREEX(fs->bfl);
+  if(i<ne) return -1; // out of memory
+  FREEX(fs->wbest);
+  for(i=0;i<ne;i++) eupd(fs,i); // an exhausted search has popped the root too, undoing its settle: so
+  for(i=0;i<nw;i++) wupd(fs,i); // look at everything again, as fillerthread() does at the start
+  return search(fs,0);
   }
 
 static void searchdone() {
@@ -976,11 +2575,16 @@ static void searchdone() {
   DEB_F0 printf("searchdone: A\n");
   gdk_threads_enter();
   DEB_F0 printf("searchdone: B\n");
+  pgseen=g_atomic_int_get(&pgseq); // final state supersedes any progress snapshot not yet shown
   if(abort_flag==0) { // finishing gracefully?
     DEB_F0 printf("finishing gracefully fillmode=%d filler_status=%d\n",fillmode,filler_status);
     if(filler_status==2) {
       mkfeas(); // construct feasible word list
-      DEB_F1 pstate(1);
+      DEB_F1 pstate(&fs0,1);
+      }
+    else if(filler_status==-6&&bpfn>=0) { // stopped at a limit: show the most complete partial assignment
+      for(i=0;i<ne;i++) entries[i].flbm=bpfl[i];
+      llistp=NULL;llistn=0; // no feasible word list
       }
     else {
       for(i=0;i<ne;i++) entries[i].flbm=0; // clear feasible letter bitmaps
@@ -996,7 +2600,7 @@ static void searchdone() {
   updategrid();
   gdk_threads_leave();
   DEB_F0 printf("searchdone: C\n");
-  state_finit();
+  state_finit(&fs0);
   for(i=0;i<nw;i++) {
     if(words[i].commitdep>=0) printf("assertion failing i=%d nw=%d words[i].commitdep=%d\n",i,nw,words[i].commitdep);
     assert(words[i].commitdep==-1); // ... and uncommitted
@@ -1010,17 +2614,44 @@ static void searchdone() {
 static gpointer fillerthread(gpointer data) {
   int i;
   clock_t ct;
+  gint64 t;
 
   DEB_F0 printf("filler_seed=0x%08x (set this using -F)\n",filler_seed);
-  srand(filler_seed);
-  ct=ct0=clock();
+  fs0.rs=fs0.seed=filler_seed;
+  fs0.heur=filler_heur;
+  filler_wseed=filler_seed;
+  filler_wheur=filler_heur;
+  memset(&fs0.st,0,sizeof(fs0.st));
+  fs0.rlim=0;
+  fs0.enm=filler_enum&&(fillmode==1||fillmode==2);
+  filler_nsol=0;
+  ct=fs0.ct0=clock();
   clueorderindex=0;
+  t=bstart=g_get_monotonic_time();
+  filler_limhit=0;
+  bpfn=-1;
+  FREEX(bpfl);
+  bon=(fillmode==1||fillmode==2)&&(filler_tlimit>0||filler_nlimit);
+  if(bon) {
+    bpfl=(ABM*)malloc(ne*sizeof(ABM));
+    if(!bpfl) {filler_status=-1; goto ex0;}
+    }
   if(buildlists()) goto ex0;
-  DEB_F1 pstate(1);
-  for(i=0;i<ne;i++) entries[i].upd=1;
-  for(i=0;i<nw;i++) words[i].upd=1;
-  if(fillmode>0||ifamode>0) filler_status=search();
+  fs0.st.tbl=g_get_monotonic_time()-t;
+  DEB_F1 pstate(&fs0,1);
+  for(i=0;i<ne;i++) entries[i].upd=0;
+  for(i=0;i<nw;i++) words[i].upd=0;
+  for(i=0;i<ne;i++) eupd(&fs0,i);
+  for(i=0;i<nw;i++) wupd(&fs0,i);
+  hbuild(&fs0);
+  scinit(&fs0);
+  if((fillmode==1||fillmode==2)&&afbest&&!fs0.enm) filler_status=bestsearch(&fs0);
+  else if((fillmode==1||fillmode==2)&&(filler_threads>1||filler_portfolio>1)) filler_status=psearch(&fs0);
+  else if(fillmode>0||ifamode>0) rinit(&fs0),filler_status=search(&fs0,0);
   else filler_status=2;
+  if(fs0.enm&&filler_status==1&&filler_nsol>0) filler_status=4; // exhausted after finding some fills: the state is not one of them
+  DEB_F0 printf("nodes=%lu backtracks=%lu backjumps=%lu nogoods learnt=%lu restarts=%lu\n",fs0.st.nodes,fs0.st.nbt,fs0.st.nbj,fs0.st.nngl,fs0.st.nrst);
+  if(fillmode!=3) fstats=fs0.st,fstatus=filler_status; // keep statistics for the report, which a pre-export run would overwrite
   if(fillmode!=3) searchdone(); // tidy up unless in pre-export mode
   DEB_F0 printf("search finished: %.3fs\n",(double)(clock()-ct)/CLOCKS_PER_SEC);
 ex0:
@@ -1038,22 +2669,26 @@ ex0:
 int filler_start(int mode) {int i,j;
   assert(fth==0);
   DEB_F0 printf("filler_start(%d)\n",mode);
-  DEB_F1 pstate(0);
   fillmode=mode;
-  if(allocstack()) return 1;
+  fs0.words=words;
+  fs0.entries=entries;
+  DEB_F1 pstate(&fs0,0);
+  if(mkewds()) return 1;
+  if(allocstack(&fs0)) return 1;
   for(i=0;i<nw;i++) {
     words[i].fe=1;
     for(j=0;j<words[i].nent;j++) if(!onebit(words[i].e[j]->flbm)) {words[i].fe=0; break;}
     }
   if(pregetinitflist()) return 1;
-  state_init();
+  pginit();
+  state_init(&fs0);
   for(i=0;i<nw;i++) words[i].commitdep=-1; // flag word uncommitted
-  state_push();
+  state_push(&fs0);
   filler_status=3;
   if(fseed) filler_seed=fseed;
   else      filler_seed=(unsigned int)rand();
   fth=g_thread_create_full(&fillerthread,0,0,1,1,(fillmode!=3)?G_THREAD_PRIORITY_LOW:G_THREAD_PRIORITY_NORMAL,0);
-  if(!fth) { state_finit(); return 1; }
+  if(!fth) { state_finit(&fs0); return 1; }
   return 0;
   }
 
@@ -1075,12 +2710,52 @@ void filler_stop(void) {
   filler_wait();
   abort_flag=0;
   DEB_F0 printf("filler_stop() B\n");
-  state_finit();
+  state_finit(&fs0);
   DEB_F0 printf("filler_stop() C\n");
   }
 
 void filler_init() {
   }
 
+// take up the latest progress snapshot, if there is a new one, into the hints bitmaps;
+// called with the GDK lock held. Returns !=0 if hints have changed, setting *nodes and *dep
+int filler_getprogress(unsigned long*nodes,int*dep) {int i,s;
+  s=g_atomic_int_get(&pgseq);
+  if(s==pgseen||pgn!=ne) return 0;
+  for(i=0;i<ne;i++) pgtmp[i]=pgbm[s&1][i];
+  *nodes=pgnodes[s&1];
+  *dep=pgdep[s&1];
+  if(g_atomic_int_get(&pgseq)!=s) return 0; // overtaken by the search: try again next time
+  for(i=0;i<ne;i++) entries[i].flbmh=pgtmp[i];
+  pgseen=s;
+  return 1;
+  }
+
+// write statistics from the last fill as a line of JSON; settle() and mkscores() times only with filler_timing
+void filler_writestats(FILE*fp) {
+  struct fstats*s=&fstats;
+  fprintf(fp,"{\"status\":%d,\"words\":%d,\"entries\":%d,",fstatus,nw,ne);
+  fprintf(fp,"\"nodes\":%lu,\"backtracks\":%lu,\"backjumps\":%lu,\"nogoods_learnt\":%lu,\"restarts\":%lu,",s->nodes,s->nbt,s->nbj,s->nngl,s->nrst);
+  fprintf(fp,"\"max_depth\":%d,\"mean_depth\":%.3f,",s->sdmax,s->nodes?(double)s->sdsum/s->nodes:0.0);
+  fprintf(fp,"\"settle_rounds\":%lu,\"settle_rounds_per_node\":%.3f,\"lights_scanned\":%lu,",s->nset,(double)s->nset/(s->nodes+1),s->nscan);
+  fprintf(fp,"\"time_buildlists\":%.6f",s->tbl*1e-6);
+  if(filler_timing) fprintf(fp,",\"time_settle\":%.6f,\"time_mkscores\":%.6f",s->tset*1e-6,s->tsc*1e-6);
+  fprintf(fp,"}\n");
+  }
+
 void filler_finit() {
+  FREEX(ewds);
+  FREEX(ewdk);
+  FREEX(ewdsi);
+  FREEX(wsco);
+  FREEX(uwds);
+  FREEX(uwdsi);
+  FREEX(awds);
+  FREEX(awdsi);
+  FREEX(ljcls);
+  FREEX(pgbm[0]);
+  FREEX(pgbm[1]);
+  FREEX(pgtmp);
+  pgn=0;
+  FREEX(bpfl);
   }
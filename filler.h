@@ -31,7 +31,28 @@ extern void filler_finit();
 extern int filler_start(int mode);
 extern void filler_wait();
 extern void filler_stop();
-extern void getposs(struct entry*e,char*s,int r,int dash);
+extern void filler_writestats(FILE*fp);
+extern int filler_getprogress(unsigned long*nodes,int*dep);
+extern void getposs(struct entry*e,char*s,int r,int dash,unsigned int*rs);
+extern void pforeach(int n,int nt,void (*f)(int,void*),void*a);
 extern int filler_status;
+extern int filler_backend;
+extern int filler_cbj;
+extern int filler_runit;
+extern double filler_bestsc;
+extern int filler_bestopt;
+extern int filler_enum;
+extern unsigned long filler_enumlim;
+extern unsigned long filler_nsol;
+extern double filler_tlimit;
+extern unsigned long filler_nlimit;
+extern int filler_limhit;
+extern int filler_timing;
+extern int filler_threads;
+extern int filler_portfolio;
+extern int filler_pfheur;
+extern int filler_heur;
+extern unsigned int filler_wseed;
+extern int filler_wheur;
 
 #endif
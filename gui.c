@@ -227,7 +227,7 @@ static int areyousure(char*action) { // general-purpose are-you-sure dialogue
   return box(GTK_MESSAGE_QUESTION,s,"  Proceed  ",GTK_STOCK_CANCEL);
   }
 
-GtkWidget*fipdia;
+GtkWidget*fipdia=0;
 static volatile int killfdflag=0;
 
 static int fiptimeout(gpointer data) {
@@ -256,6 +256,17 @@ static void runfipdia() {
   DEB_GU printf("leaving runfipdia %p...\n",(void*)fipdia);
   g_source_remove(id);
   gtk_widget_destroy(fipdia);
+  fipdia=0;
+  }
+
+// show the filler's latest progress snapshot; runs from the main loop with the GDK lock held
+static int progtimeout(gpointer data) {
+  unsigned long n;
+  int d;
+  if(!filler_getprogress(&n,&d)) return 1;
+  refreshhin();
+  if(fipdia) gtk_message_dialog_format_secondary_text(GTK_MESSAGE_DIALOG(fipdia),"%lu decisions, now at depth %d",n,d);
+  return 1;
   }
 
 // note this function is called from a different thread
@@ -704,6 +715,7 @@ static void m_accept(GtkWidget*w,gpointer data) {
 static void m_unban(GtkWidget*w,gpointer data) {
   int i;
   for(i=0;i<atotal;i++) ansp[i]->banned=0;
+  invalflcache();
   gridchange();
   }
 
@@ -1327,6 +1339,7 @@ static int banword(GtkWidget*menuitem,gpointer data) {
   u=(int)(intptr_t)data;
 //  printf("Ban %d (atotal=%d)\n",u,atotal);
   if(u>=0&&u<atotal) ansp[u]->banned=1;
+  invalflcache();
   gridchange();
   gtk_window_set_focus(GTK_WINDOW(mainw),grid_da);
   return 1;
@@ -2869,7 +2882,7 @@ static int ddict_browse(GtkWidget*w,gpointer p) {
 
 // preferences dialogue
 static int prefsdia(void) {
-  GtkWidget*dia,*l,*w,*w30,*w31,*w32,*w00,*w01,*w02,*w20,*w21,*w10,*w11,*w12,*w14,*t,*le0[NLOOKUP],*le1[NLOOKUP],*vb,*nb,*dal,*b,*f01,*f11;
+  GtkWidget*dia,*l,*w,*w30,*w31,*w32,*w00,*w01,*w02,*w20,*w21,*w10,*w11,*w12,*w14,*w15,*w16,*w17,*w18,*w19,*t,*le0[NLOOKUP],*le1[NLOOKUP],*vb,*nb,*dal,*b,*f01,*f11;
   int i;
   char s[SLEN+1];
   dia=gtk_dialog_new_with_buttons("Preferences",GTK_WINDOW(mainw),GTK_DIALOG_DESTROY_WITH_PARENT,
@@ -2925,6 +2938,16 @@ static int prefsdia(void) {
   w12=gtk_radio_button_new_with_label_from_widget(GTK_RADIO_BUTTON(w11),"Highly randomised");   gtk_box_pack_start(GTK_BOX(vb),w12,FALSE,FALSE,0);
   w=gtk_hseparator_new();                                                                       gtk_box_pack_start(GTK_BOX(vb),w,FALSE,FALSE,0);
   w14=gtk_check_button_new_with_label("Prevent duplicate answers and lights");                  gtk_box_pack_start(GTK_BOX(vb),w14,FALSE,FALSE,0);
+  w=gtk_hseparator_new();                                                                       gtk_box_pack_start(GTK_BOX(vb),w,FALSE,FALSE,0);
+  w15=gtk_radio_button_new_with_label_from_widget(NULL,"Never restart");                        gtk_box_pack_start(GTK_BOX(vb),w15,FALSE,FALSE,0);
+  w16=gtk_radio_button_new_with_label_from_widget(GTK_RADIO_BUTTON(w15),"Restart on Luby schedule"); gtk_box_pack_start(GTK_BOX(vb),w16,FALSE,FALSE,0);
+  w17=gtk_radio_button_new_with_label_from_widget(GTK_RADIO_BUTTON(w16),"Restart on geometric schedule"); gtk_box_pack_start(GTK_BOX(vb),w17,FALSE,FALSE,0);
+  w18=gtk_check_button_new_with_label("Favour entries that have caused failures");              gtk_box_pack_start(GTK_BOX(vb),w18,FALSE,FALSE,0);
+  w=gtk_hseparator_new();                                                                       gtk_box_pack_start(GTK_BOX(vb),w,FALSE,FALSE,0);
+  w=gtk_hbox_new(0,3);                                                                          gtk_box_pack_start(GTK_BOX(vb),w,FALSE,FALSE,0);
+  l=gtk_label_new(" Look for the best fill for ");                                              gtk_box_pack_start(GTK_BOX(w),l,FALSE,FALSE,0);
+  w19=gtk_spin_button_new_with_range(0,3600,1);                                                 gtk_box_pack_start(GTK_BOX(w),w19,FALSE,FALSE,0);
+  l=gtk_label_new(" seconds (0 to stop at first fill) ");                                       gtk_box_pack_start(GTK_BOX(w),l,FALSE,FALSE,0);
 
   vb=gtk_vbox_new(0,3); // box to hold all the options
   gtk_notebook_append_page(GTK_NOTEBOOK(nb),vb,gtk_label_new("Lookup"));
@@ -2991,6 +3014,11 @@ static int prefsdia(void) {
   if(afrandom==0) gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(w10),1);
   if(afrandom==1) gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(w11),1);
   if(afrandom==2) gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(w12),1);
+  if(afrestart==0) gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(w15),1);
+  if(afrestart==1) gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(w16),1);
+  if(afrestart==2) gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(w17),1);
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(w18),afrweights);
+  gtk_spin_button_set_value(GTK_SPIN_BUTTON(w19),afbest);
 
   gtk_widget_show_all(dia);
   i=gtk_dialog_run(GTK_DIALOG(dia));
@@ -3016,6 +3044,13 @@ static int prefsdia(void) {
     if(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(w10))) afrandom=0;
     if(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(w11))) afrandom=1;
     if(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(w12))) afrandom=2;
+    if(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(w15))) afrestart=0;
+    if(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(w16))) afrestart=1;
+    if(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(w17))) afrestart=2;
+    afrweights=gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(w18));
+    afbest=gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(w19));
+    if(afbest<   0) afbest=   0;
+    if(afbest>3600) afbest=3600;
     for(i=0;i<NLOOKUP;i++) {
       strncpy(lookupname(i),gtk_entry_get_text(GTK_ENTRY(le0[i])),SLEN-1); lookupname(i)[SLEN]=0;
       strncpy(lookup(i)    ,gtk_entry_get_text(GTK_ENTRY(le1[i])),SLEN-1); lookup    (i)[SLEN]=0;
@@ -3241,7 +3276,7 @@ void updatefeas(void) {
     }
   if(curent>=0&&curword>=0&&words[curword].fe==0) {
     if(entries[curent].flbm==0) strcpy(p0,"");
-    else getposs(entries+curent,p0,0,0); // get feasible letter list with dash suppressed
+    else getposs(entries+curent,p0,0,0,0); // get feasible letter list with dash suppressed
     if(strlen(p0)==0) sprintf(p1," No feasible characters");
     else {
       sprintf(p1," Feasible character%s: ",(strlen(p0)==1)?"":"s");
@@ -3600,6 +3635,7 @@ void startgtk(void) {
 
   gtk_widget_show_all(mainw);
   gtk_window_set_focus(GTK_WINDOW(mainw),grid_da);
+  gdk_threads_add_timeout(200,progtimeout,0); // poll for filler progress
   }
 
 void stopgtk(void) {
@@ -794,6 +794,10 @@ void freewords() {
       FREEX(words[i].jdata);
       FREEX(words[i].jflbm);
       FREEX(words[i].sdata);
+      FREEX(words[i].fsc);
+      words[i].fcol=0;
+      FREEX(words[i].fbs);
+      FREEX(words[i].bsi);
       words[i].flistlen=0;
       }
   FREEX(words);
@@ -1185,10 +1189,10 @@ void a_editmerge(int k,int x,int y,int d) {int f,i,l,tl,tx,ty,gx[MXCL],gy[MXCL],
 // PREFERENCES
 
 
-static int preftype[NPREFS]=       {0,0,0,  0,  0,0,0, 0, 0,0, 1,1,1,1,1,1, 1,1,1,1,1,1, 1,1,1,0            }; // 0=int, 1=string
-static int prefminv[NPREFS]=       {0,0,0,  0,  0,0,0,10,10,0, 0,0,0,0,0,0, 0,0,0,0,0,0, 0,0,0,0            }; // legal range
-static int prefmaxv[NPREFS]=       {1,1,1,100,100,1,2,72,72,1, 0,0,0,0,0,0, 0,0,0,0,0,0, 0,0,0,NALPHAINIT-1 };
-static int prefdatadefault[NPREFS]={0,0,1, 66, 75,1,0,36,36,0, 0,0,0,0,0,0, 0,0,0,0,0,0, 0,0,0,ALPHABET_AZ09};
+static int preftype[NPREFS]=       {0,0,0,  0,  0,0,0, 0, 0,0, 1,1,1,1,1,1, 1,1,1,1,1,1, 1,1,1,0,            0,0,0}; // 0=int, 1=string
+static int prefminv[NPREFS]=       {0,0,0,  0,  0,0,0,10,10,0, 0,0,0,0,0,0, 0,0,0,0,0,0, 0,0,0,0,            0,0,0}; // legal range
+static int prefmaxv[NPREFS]=       {1,1,1,100,100,1,2,72,72,1, 0,0,0,0,0,0, 0,0,0,0,0,0, 0,0,0,NALPHAINIT-1, 2,1,3600};
+static int prefdatadefault[NPREFS]={0,0,1, 66, 75,1,0,36,36,0, 0,0,0,0,0,0, 0,0,0,0,0,0, 0,0,0,ALPHABET_AZ09,0,0,0};
 static char prefstringdefault[NPREFS][SLEN+1]={
   "", "", "", "", "",
   "", "", "", "", "",
@@ -1204,7 +1208,8 @@ static char prefstringdefault[NPREFS][SLEN+1]={
   "https://en.wikipedia.org/w/index.php?search=%s",
   "https://www.startpage.com/do/search?q=%s",
   "https://www.dictionary.com/browse/%s?s=t",
-  "","","",""
+  "","","","",
+  "","",""
   };
 
 int prefdata[NPREFS]={0};
@@ -1218,7 +1223,8 @@ static char*prefname[NPREFS]={ // names as used in preferences file
   "light_numbers_in_solutions",
   "lookupname_0", "lookupname_1", "lookupname_2", "lookupname_3", "lookupname_4", "lookupname_5",
   "lookupuri_0",  "lookupuri_1",  "lookupuri_2",  "lookupuri_3",  "lookupuri_4",  "lookupuri_5", 
-  "startup_defdict1", "startup_ff1", "startup_af1", "startup_al"
+  "startup_defdict1", "startup_ff1", "startup_af1", "startup_al",
+  "autofill_restart", "autofill_restart_weights", "autofill_best_seconds"
   };
 
 static void loadprefdefaults() {
@@ -1237,17 +1243,26 @@ FILE*openprefs(int mode) {
   return _wfopen(sw,mode?L"r":L"w");
 #else
   char s[SLEN];
+  if(userpath(s,"preferences",mode==0)) return 0;
+  return g_fopen(s,mode?"r":"w");
+#endif
+  }
+
+#ifndef _WIN32
+// put the path of file fn in the per-user .qxw directory in s, creating the directory if mk is set; returns !=0 on failure
+int userpath(char*s,const char*fn,int mk) {
   struct passwd*p;
   p=getpwuid(getuid());
-  if(!p) return 0;
-  if(strlen(p->pw_dir)>SLEN-20) return 0;
+  if(!p) return 1;
+  if(strlen(p->pw_dir)+strlen(fn)>SLEN-20) return 1;
   strcpy(s,p->pw_dir);
   strcat(s,"/.qxw");
-  if(mode==0) mkdir(s,0777);
-  strcat(s,"/preferences");
-  return g_fopen(s,mode?"r":"w");
-#endif
+  if(mk) mkdir(s,0777);
+  strcat(s,"/");
+  strcat(s,fn);
+  return 0;
   }
+#endif
 
 // read preferences from file
 // fail silently
@@ -2195,9 +2210,16 @@ extern int optind,opterr,optopt;
 int main(int argc,char*argv[]) {
   int i,j,nd;
   char alphabet[SLEN+1]="";
+  char statsfn[SLEN+1]=""; // where to write filler statistics in batch mode, "-" for stderr
   int deckmode=0;
+  FILE*fp;
   int rc=0; // return code
   unsigned int rseed;
+  #ifdef _WIN32
+    wchar_t*oe; // end of numeric option argument
+  #else
+    char*oe;
+  #endif
 
   rseed=(unsigned int)time(0);
   fseed=0;
@@ -2213,34 +2235,78 @@ int main(int argc,char*argv[]) {
   #ifdef _WIN32
 		int wArgc;
 		LPWSTR* wArgv = CommandLineToArgvW(GetCommandLineW(), &wArgc);
-		for (;;) switch (getoptw(wArgc, wArgv, L"a:bd:?D:R:F:")) {
+		for (;;) switch (getoptw(wArgc, wArgv, L"a:bB:d:?D:J:L:N:R:F:P:S:T:")) {
 		case -1: goto ew0;
 		case L'a':
 			if (wcslen(optarg) < SLEN) WideCharToMultiByte(CP_UTF8, 0, optarg, -1, alphabet, SLEN, NULL, NULL);
 			break;
 		case L'b':deckmode = 1; break;
+		case L'B':filler_backend = wcstol(optarg, 0, 0); break;
 		case L'd':
 			if (wcslen(optarg) < SLEN && nd < MAXNDICTS) WideCharToMultiByte(CP_UTF8, 0, optarg, -1, dfnames[nd++], SLEN, NULL, NULL);
 			break;
 		case L'D':debug = wcstol(optarg, 0, 0) | 0x80000000; break;
+		case L'J':filler_cbj = wcstol(optarg, 0, 0); break;
+		case L'L':
+			filler_tlimit = wcstod(optarg, &oe);
+			if (!iswdigit(*optarg) || *oe) i = 1;
+			break;
+		case L'N':
+			filler_nlimit = wcstoul(optarg, &oe, 0);
+			if (!iswdigit(*optarg) || *oe) i = 1;
+			break;
 		case L'R':rseed = (unsigned int)wcstol(optarg, 0, 0); break;
 		case L'F':fseed = (unsigned int)wcstol(optarg, 0, 0); break;
+		case L'P':
+			filler_portfolio = wcstol(optarg, &oe, 0);
+			if (*oe || filler_portfolio < 1 || filler_portfolio > 64) i = 1;
+			break;
+		case L'S':
+			if (wcslen(optarg) < SLEN) WideCharToMultiByte(CP_UTF8, 0, optarg, -1, statsfn, SLEN, NULL, NULL);
+			filler_timing = 1;
+			break;
+		case L'T':
+			filler_threads = wcstol(optarg, &oe, 0);
+			if (*oe || filler_threads < 1 || filler_threads > 64) i = 1;
+			break;
 		case L'?':
 		default:i = 1; break;
 		}
   #else
-		for (;;) switch (getopt(argc, argv, "a:bd:?D:R:F:")) {
+		for (;;) switch (getopt(argc, argv, "a:bB:d:?D:J:L:N:R:F:P:S:T:")) {
 		case -1: goto ew0;
 		case 'a':
 			if (strlen(optarg) < SLEN) strcpy(alphabet, optarg);
 			break;
 		case 'b':deckmode = 1; break;
+		case 'B':filler_backend = strtol(optarg, 0, 0); break;
 		case 'd':
 			if (strlen(optarg) < SLEN && nd < MAXNDICTS) strcpy(dfnames[nd++], optarg);
 			break;
 		case 'D':debug = strtol(optarg, 0, 0) | 0x80000000; break;
+		case 'J':filler_cbj = strtol(optarg, 0, 0); break;
+		case 'L':
+			filler_tlimit = strtod(optarg, &oe);
+			if (!isdigit((unsigned char)*optarg) || *oe) i = 1;
+			break;
+		case 'N':
+			filler_nlimit = strtoul(optarg, &oe, 0);
+			if (!isdigit((unsigned char)*optarg) || *oe) i = 1;
+			break;
 		case 'R':rseed = (unsigned int)strtol(optarg, 0, 0); break;
 		case 'F':fseed = (unsigned int)strtol(optarg, 0, 0); break;
+		case 'P':
+			filler_portfolio = strtol(optarg, &oe, 0);
+			if (*oe || filler_portfolio < 1 || filler_portfolio > 64) i = 1;
+			break;
+		case 'S':
+			if (strlen(optarg) < SLEN) strcpy(statsfn, optarg);
+			filler_timing = 1;
+			break;
+		case 'T':
+			filler_threads = strtol(optarg, &oe, 0);
+			if (*oe || filler_threads < 1 || filler_threads > 64) i = 1;
+			break;
 		case '?':
 		default:i = 1; break;
 		}
@@ -2269,7 +2335,21 @@ int main(int argc,char*argv[]) {
     printf("   OR: %s -b [-a <initial alphabet code>] [-d <dictionary_file>]* <qxw_deck>\n",argv[0]);
     printf("\n"
       "-b enables batch mode: GUI is disabled and a Qxw deck is read from the\n"
-      "     specified file\n\n");
+      "     specified file\n"
+      "-B <n> selects the filler backend: 0 scans word lists (default); 1 uses\n"
+      "     bitset indexes on long word lists\n"
+      "-J <n> selects how the filler backtracks: 0 one level at a time (default);\n"
+      "     1 jumps back to the decisions responsible for a dead end; 2 also\n"
+      "     remembers short combinations of letters that have led to dead ends\n"
+      "-L <s> in batch mode, stops filling after <s> seconds; the most complete\n"
+      "     partial fill reached is output instead\n"
+      "-N <n> in batch mode, stops filling after <n> decisions, as -L\n"
+      "-P <n> races <n> (1..64) independently seeded fillers against each other and\n"
+      "     keeps the first fill found; the winning seed is reported\n"
+      "-S <file> in batch mode, writes filler statistics as JSON to the specified\n"
+      "     file, or to standard error if <file> is -, including time spent in\n"
+      "     each stage of the search\n"
+      "-T <n> sets the number of threads used to search for a fill, 1..64 (default 1)\n\n");
     printf("Available alphabets and corresponding names and codes:\n");
     for(i=0;i<NALPHAINIT;i++) {
       printf("%30s: ",alphaname[i][0]);
@@ -2330,6 +2410,12 @@ int main(int argc,char*argv[]) {
       } else {
         filler_wait();
         rc=dumpdeck();
+        if(rc==8&&!statsfn[0]) strcpy(statsfn,"-"); // stopped at a limit: always report statistics
+        if(statsfn[0]) {
+          if(!strcmp(statsfn,"-")) filler_writestats(stderr);
+          else if((fp=fopen(statsfn,"w"))) filler_writestats(fp),fclose(fp);
+          else fprintf(stderr,"Cannot write statistics file %s\n",statsfn);
+          }
         }
       }
   } else { // GUI mode
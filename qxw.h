@@ -72,6 +72,9 @@ extern struct lprop*getlprop(int x,int y,int d);
 extern void getmk(char*s,int x,int y,int c);
 
 extern FILE* q_fopen(char* filename, char* mode);
+#ifndef _WIN32
+extern int userpath(char*s,const char*fn,int mk);
+#endif
 extern void a_load(void);
 extern void a_save(void);
 extern void a_importvls(char*fn);
@@ -26,6 +26,7 @@ Fifth Floor, Boston, MA  02110-1301, USA.
 #include "qxw.h"
 #include "dicts.h"
 #include "treatment.h"
+#include "filler.h"
 #include "gui.h"
 
 #ifdef _WIN32  // using wrapper for Windows dynamic linking functions
@@ -38,7 +39,7 @@ Fifth Floor, Boston, MA  02110-1301, USA.
 
 // INITIAL FEASIBLE LIST GENERATION
 
-static int curans,curem,curten,curdm;
+static int curem,curten,curdm;
 
 int treatmode=0,treatorder[NMSG]={0,0};
 char tpifname[SLEN]="";
@@ -95,6 +96,15 @@ static int psc[MAXICC]; // ICC to square position, -1 if not present
 static int*tfl=0; // temporary feasible list
 static int ctfl,ntfl;
 
+struct tsink { // where the lights got by treating an answer go
+  int a;                        // answer being treated
+  int q;                        // queue lights in b to be added to the feasible list later, rather than adding them now?
+  char*b;                       // queued lights, each as answer, entry method and 0-terminated string
+  int n,c;                      // bytes used and allocated in b
+  int u;                        // status of a chunk of answers treated in parallel, as getinitflist()
+  };
+static struct tsink tss={0};    // adds lights to the feasible list directly
+
 static int clts;
 static int hstab[HTABSZ];
 static int haestab[HTABSZ];
@@ -213,18 +223,12 @@ int ICCtoclass(char c) {
   return icctogroup[(int)c];
   }
 
-// add light to feasible list: s=text of light (in internal character code), a=answer from which treated (-ve for msgword), e=entry method
+// add light to feasible list: t=text of light including any tags, a=answer from which treated (-ve for msgword), e=entry method
 // returns 0 if OK, !=0 on (out of memory) error
-static int addlight(const char*s,int a,int e) {
+static int addlight1(const char*t,int a,int e) {
   int l;
   int*p;
-  char t[MXFL+1]; // curten should never be set when adding msgword[]:s (got from msglprop); as MXLE+NMSG<=MXFL this never overflows
 
-  l=strlen(s);
-  if(l<1) return 0; // is this test needed?
-  memcpy(t,s,l);
-  if(curten) memcpy(t+l,msgcharICC,NMSG),l+=NMSG; // append tag characters if any
-  t[l]=0;
   l=findlight(t,curten,a,e);
   if(l<0) return l;
   if(ntfl>=ctfl) {
@@ -238,9 +242,34 @@ static int addlight(const char*s,int a,int e) {
   return 0;
   }
 
-// Add treated answer (in internal character code) to feasible light list if suitable
+// send light to ts: s=text of light (in internal character code), e=entry method
+// returns 0 if OK, !=0 on (out of memory) error
+static int addlight(struct tsink*ts,const char*s,int e) {
+  int l;
+  char*p;
+  char t[MXFL+1]; // curten should never be set when adding msgword[]:s (got from msglprop); as MXLE+NMSG<=MXFL this never overflows
+
+  l=strlen(s);
+  if(l<1) return 0; // is this test needed?
+  memcpy(t,s,l);
+  if(curten) memcpy(t+l,msgcharICC,NMSG),l+=NMSG; // append tag characters if any
+  t[l]=0;
+  if(!ts->q) return addlight1(t,ts->a,e);
+  if(ts->n+(int)sizeof(int)+l+2>ts->c) {
+    ts->c=ts->c*2+4096;
+    p=realloc(ts->b,ts->c);
+    if(!p) return -1;
+    ts->b=p;
+    }
+  memcpy(ts->b+ts->n,&ts->a,sizeof(int)); ts->n+=sizeof(int);
+  ts->b[ts->n++]=e;
+  memcpy(ts->b+ts->n,t,l+1); ts->n+=l+1;
+  return 0;
+  }
+
+// Send treated answer (in internal character code) to ts if suitable
 // returns !=0 for error
-int treatedanswerICC(const char*s) {
+static int tanswer(struct tsink*ts,const char*s) {
   char s0[MXFL+1];
   int j,k,l,u;
 
@@ -250,22 +279,22 @@ int treatedanswerICC(const char*s) {
   DEB_FL assert(l>0);
   if(tambaw&&!iswordICC(s)) return 0;
   if(curem&EM_JUM) { // jumbled entry method
-    return addlight(s,curans,4); // just store normal entry
+    return addlight(ts,s,4); // just store normal entry
     }
   if(curem&EM_FWD) { // forwards entry method
-    u=addlight(s,curans,0);if(u) return u;
+    u=addlight(ts,s,0);if(u) return u;
     }
   if(curem&EM_REV) {
     for(j=0;j<l;j++) s0[j]=s[l-j-1]; // reversed entry method
     s0[j]=0;
-    u=addlight(s0,curans,1);if(u) return u;
+    u=addlight(ts,s0,1);if(u) return u;
     }
   if(curem&EM_CYC) { // cyclic permutation
     if(!(l==2&&(curem&EM_REV))) { // not if already covered by reversal
       for(k=1;k<l;k++) {
         for(j=0;j<l;j++) s0[j]=s[(j+k)%l];
         s0[j]=0;
-        u=addlight(s0,curans,2);if(u) return u;
+        u=addlight(ts,s0,2);if(u) return u;
         }
       }
     }
@@ -274,13 +303,17 @@ int treatedanswerICC(const char*s) {
       for(k=1;k<l;k++) {
         for(j=0;j<l;j++) s0[j]=s[(l-j-1+k)%l];
         s0[j]=0;
-        u=addlight(s0,curans,3);if(u) return u;
+        u=addlight(ts,s0,3);if(u) return u;
         }
       }
     }
   return 0;
   }
 
+// Add treated answer (in internal character code) to feasible light list if suitable
+// returns !=0 for error
+int treatedanswerICC(const char*s) {return tanswer(&tss,s);}
+
 // as above, but s converted from uchars
 int treatedanswerU(const uchar*s) {
   int i,j,u;
@@ -380,6 +413,7 @@ void unloadtpi(void) {void (*f)();
 void reloadtpi(void) {
   char s[300],*p;
   if(treatmode==TREAT_PLUGIN) {
+    invalflcache(); // plug-in may have changed
     if((p=loadtpi())) {
       sprintf(s,"Error loading custom plug-in\n%.200s",p);
       reperr(s);
@@ -403,7 +437,7 @@ static int offsetenc(int c0,int c1) {
 
 // returns !=0 on error
 // s points to answer to be treated in internal character code
-static int treatans(const char*s) {
+static int treatans(struct tsink*ts,const char*s) {
   int c0,c1,c2,d0,d1,g,i,j,l,l0,l1,o,u;
   char ansutf8[MXFL*8],*p;
   uchar ansU[MXFL+1];
@@ -413,7 +447,7 @@ static int treatans(const char*s) {
   for(i=0;s[i];i++) if(s[i]>=MAXICC) return 0;
   switch(treatmode) {
 case 0: // no treatment
-    return treatedanswerICC(s);
+    return tanswer(ts,s);
 case 1: // Playfair
     if(l!=lightlength) return 0;
     strcpy(t,s);
@@ -427,7 +461,7 @@ case 1: // Playfair
       else                d0=psq[ l0/5     *5+ l1   %5],d1=psq[ l1/5     *5+ l0   %5]; // rectangle
       if(d0!=0&&d1!=0) t[i]=d0,t[i+1]=d1; // successfully encoded?
       } // if l is odd last character is not encoded
-    return treatedanswerICC(t);
+    return tanswer(ts,t);
 case 2: // substitution
     if(l!=lightlength) return 0;
     l0=strlen(treatmsgICC[0]);
@@ -441,48 +475,48 @@ case 2: // substitution
       if(j>=l0) continue;
       t[i]=treatmsgICC[0][j];
       }
-    return treatedanswerICC(t);
+    return tanswer(ts,t);
 case 3: // fixed Caesar/Vigenère
     if(l!=lightlength) return 0;
     l0=strlen(treatmsgICC[0]);
-    if(l0==0) return treatedanswerICC(s); // no keyword, so leave as plaintext
-    if(niccused<1) return treatedanswerICC(s); // prevent divide-by-0
+    if(l0==0) return tanswer(ts,s); // no keyword, so leave as plaintext
+    if(niccused<1) return tanswer(ts,s); // prevent divide-by-0
     strcpy(t,s);
     for(i=0;s[i];i++) {
       c0=icctousedindex[(int)s[i]];
       c1=icctousedindex[(int)treatmsgICC[0][i%l0]];
       if(c0>=0&&c1>=0) t[i]=iccused[offsetenc(c0,c1)];
       }
-    return treatedanswerICC(t);
+    return tanswer(ts,t);
 case 4: // variable Caesar
     if(l!=lightlength) return 0;
-    if(niccused<1) return treatedanswerICC(s); // prevent divide-by-0
+    if(niccused<1) return tanswer(ts,s); // prevent divide-by-0
     if(treatorder[0]==0) { // for backwards compatibility
       l0=strlen(treatmsgICC[0]);
-      if(l0==0) return treatedanswerICC(s); // no keyword, so leave as plaintext
+      if(l0==0) return tanswer(ts,s); // no keyword, so leave as plaintext
       o=treatmsgICC[0][clueorderindex%l0];
     } else {
       o=msgcharICC[0];
-      if(o==ICC_DASH) return treatedanswerICC(s); // leave as plaintext
+      if(o==ICC_DASH) return tanswer(ts,s); // leave as plaintext
       }
     c1=icctousedindex[o];
-    if(c1<0) return treatedanswerICC(s);
+    if(c1<0) return tanswer(ts,s);
     strcpy(t,s);
     for(i=0;s[i];i++) {
       c0=icctousedindex[(int)s[i]];
       if(c0>=0) t[i]=iccused[offsetenc(c0,c1)];
       }
-    return treatedanswerICC(t);
+    return tanswer(ts,t);
 case 10: // misprint, correct letters specified
     if(l!=lightlength) return 0;
     c0=msgcharICC[0];
-    if(c0==ICC_DASH) return treatedanswerICC(s); // unmisprinted
+    if(c0==ICC_DASH) return tanswer(ts,s); // unmisprinted
     c1=0;
     goto misp0;
 case 11: // misprint, misprinted letters specified
     if(l!=lightlength) return 0;
     c1=msgcharICC[0];
-    if(c1==ICC_DASH) return treatedanswerICC(s); // unmisprinted
+    if(c1==ICC_DASH) return tanswer(ts,s); // unmisprinted
     c0=0;
     goto misp0;
 case 5: // misprint
@@ -491,7 +525,7 @@ case 5: // misprint
     l1=ucharslen(treatmsgU[1]);
     c0=0; if(clueorderindex<l0) c0=uchartoICC(treatmsgU[0][clueorderindex]); // will be left at 0 if not a recognised character
     c1=0; if(clueorderindex<l1) c1=uchartoICC(treatmsgU[1][clueorderindex]);
-    if(c0==0&&c1==0) return treatedanswerICC(s); // allowing this case would slow things down too much for now
+    if(c0==0&&c1==0) return tanswer(ts,s); // allowing this case would slow things down too much for now
 misp0: // here we want to misprint c0 as c1, where 0 indicates any character
     strcpy(t,s);
     for(i=0;s[i];i++) if(c0==0||s[i]==c0) {
@@ -500,13 +534,13 @@ misp0: // here we want to misprint c0 as c1, where 0 indicates any character
           c2=iccused[j];
           if(s[i]==c2) continue; // not a *mis*print
           t[i]=c2;
-          u=treatedanswerICC(t); if(u) return u;
+          u=tanswer(ts,t); if(u) return u;
           t[i]=s[i]; // restore modified character
           }
       } else {
         if(c0==0&&s[i]==c1) continue; // not a *mis*print unless specifically instructed otherwise
         t[i]=c1;
-        u=treatedanswerICC(t); if(u) return u;
+        u=tanswer(ts,t); if(u) return u;
         t[i]=s[i]; // restore modified character
         if(c0==c1) break; // only one entry for the `misprint as self' case
         }
@@ -515,7 +549,7 @@ misp0: // here we want to misprint c0 as c1, where 0 indicates any character
 case 6: // delete single occurrence
     c0=msgcharICC[0];
     if(c0==ICC_DASH) {
-      if(l==lightlength) return treatedanswerICC(s);
+      if(l==lightlength) return tanswer(ts,s);
       return 0;
       }
     if(l!=lightlength+1) return 0;
@@ -523,25 +557,25 @@ case 6: // delete single occurrence
       for(j=0;j<i;j++) t[j]=s[j];
       for(;s[j+1];j++) t[j]=s[j+1];
       t[j]=0;
-      u=treatedanswerICC(t); if(u) return u;
+      u=tanswer(ts,t); if(u) return u;
       while(s[i+1]==c0) i++; // skip duplicate outputs
       }
     return 0;
 case 7: // delete all occurrences (letters latent)
     c0=msgcharICC[0];
     if(c0==ICC_DASH) {
-      if(l==lightlength) return treatedanswerICC(s);
+      if(l==lightlength) return tanswer(ts,s);
       return 0;
       }
     if(l<=lightlength) return 0;
     for(i=0,j=0;s[i];i++) if(s[i]!=c0) t[j++]=s[i];
     t[j]=0;
     if(j!=lightlength) return 0; // not necessary, but improves speed slightly
-    return treatedanswerICC(t);
+    return tanswer(ts,t);
 case 8: // insert single character
     c0=msgcharICC[0];
     if(c0==ICC_DASH) {
-      if(l==lightlength) return treatedanswerICC(s);
+      if(l==lightlength) return tanswer(ts,s);
       return 0;
       }
     if(l!=lightlength-1) return 0;
@@ -550,7 +584,7 @@ case 8: // insert single character
       t[j++]=c0;
       for(;s[j-1];j++) t[j]=s[j-1];
       t[j]=0;
-      u=treatedanswerICC(t); if(u) return u;
+      u=tanswer(ts,t); if(u) return u;
       while(s[i]==c0) i++; // skip duplicate outputs
       }
     return 0;
@@ -567,13 +601,103 @@ default:break;
   return 0;
   }
 
+// untreated length of the answers that can give rise to a light of length lightlength
+// with the current msgchar:s, or -1 if it could be any length
+static int untreatedlength(void) {
+  if(!curten) return lightlength;
+  switch(treatmode) {
+case 0: case 1: case 2: case 3: case 4: case 5: case 10: case 11: // length-preserving treatments
+    return lightlength;
+case 6: // delete single occurrence
+    return msgcharICC[0]==ICC_DASH?lightlength:lightlength+1;
+case 7: // delete all occurrences
+    return msgcharICC[0]==ICC_DASH?lightlength:-1;
+case 8: // insert single character
+    return msgcharICC[0]==ICC_DASH?lightlength:lightlength-1;
+default: // custom plug-in
+    return -1;
+    }
+  }
+
+// INITIAL LIST CACHE
+
+// Initial feasible lists are kept from one run of the filler to the next, keyed by the properties of the
+// light they depend on, so that only lists not seen before are built from the dictionaries; words with the
+// same key share one cached list and are each given a copy of it, as the filler narrows lists in place.
+// The lights in lts[] are kept for as long as the cache is valid. The cache is invalidated when the
+// dictionaries are reloaded, when answers are banned or unbanned, and when the treatment changes.
+
+struct flcent { // cached initial feasible list
+  struct flcent*next;
+  int llen;
+  unsigned int dm;
+  int em;
+  int coi;                  // clueorderindex for a treated light, -1 otherwise
+  int n;                    // length of list
+  int*l;                    // the list
+  };
+
+static struct flcent*flc=0;
+static volatile int flcvalid=0;
+
+// treatment settings the cached lists were built with
+static int flctmode,flctorder[NMSG],flctambaw,flcntw;
+static char flctmsg[NMSG][MXLT*8+1];
+static ABM flctcstr[NMSG][MXFL];
+static char flctpifname[SLEN];
+
+// mark the cache as invalid; it is cleared the next time the filler starts
+void invalflcache(void) {flcvalid=0;}
+
+static void freeflcache(void) {struct flcent*p;
+  while(flc) {p=flc->next;free(flc->l);free(flc);flc=p;}
+  }
+
+// have the treatment settings changed since the cache was built?
+static int flctchanged(void) {int i;
+  if(treatmode!=flctmode||tambaw!=flctambaw||ntw!=flcntw||strcmp(tpifname,flctpifname)) return 1;
+  for(i=0;i<NMSG;i++) if(treatorder[i]!=flctorder[i]||strcmp(treatmsg[i],flctmsg[i])) return 1;
+  return !!memcmp(treatcstr,flctcstr,sizeof(treatcstr));
+  }
+
+static void flctsave(void) {int i;
+  flctmode=treatmode;
+  flctambaw=tambaw;
+  flcntw=ntw;
+  strcpy(flctpifname,tpifname);
+  for(i=0;i<NMSG;i++) flctorder[i]=treatorder[i],strcpy(flctmsg[i],treatmsg[i]);
+  memcpy(flctcstr,treatcstr,sizeof(treatcstr));
+  }
+
+static struct flcent*flcfind(int llen,unsigned int dm,int em,int coi) {struct flcent*p;
+  for(p=flc;p;p=p->next) if(p->llen==llen&&p->dm==dm&&p->em==em&&p->coi==coi) return p;
+  return 0;
+  }
+
+// add the list just built to the cache; failing for lack of memory is harmless
+static void flcadd(int llen,unsigned int dm,int em,int coi) {struct flcent*p;
+  p=(struct flcent*)malloc(sizeof(struct flcent));
+  if(!p) return;
+  p->l=(int*)malloc(ntfl*sizeof(int)+1);
+  if(!p->l) {free(p); return;}
+  memcpy(p->l,tfl,ntfl*sizeof(int));
+  p->llen=llen,p->dm=dm,p->em=em,p->coi=coi,p->n=ntfl;
+  p->next=flc;
+  flc=p;
+  }
+
 int pregetinitflist(void) {
   int i;
   struct memblk*p;
-  while(lstrings) {p=lstrings->next;free(lstrings);lstrings=p;} lmp=0; lml=MEMBLK;
+  if(!flcvalid||flctchanged()) { // start again from scratch
+    freeflcache();
+    while(lstrings) {p=lstrings->next;free(lstrings);lstrings=p;} lmp=0; lml=MEMBLK;
+    FREEX(lts);clts=0;ltotal=0;ultotal=0;
+    for(i=0;i<HTABSZ;i++) hstab[i]=-1,haestab[i]=-1;
+    flctsave();
+    flcvalid=1;
+    }
   FREEX(tfl);ctfl=0;ntfl=0;
-  FREEX(lts);clts=0;ltotal=0;ultotal=0;
-  for(i=0;i<HTABSZ;i++) hstab[i]=-1,haestab[i]=-1;
   if(inittreat()) return 1;
   return 0;
   }
@@ -585,14 +709,82 @@ int postgetinitflist(void) {
   return 0;
   }
 
+// send the lights from answer a to ts; returns !=0 on error
+static int treat1(struct tsink*ts,int a) {
+  if((curdm&ansp[a]->dmask)==0) return 0; // not in a valid dictionary
+  if(ansp[a]->banned) return 0;
+  ts->a=a;
+  if(curten) return treatans(ts,ansp[a]->ul);
+  else       return tanswer(ts,ansp[a]->ul);
+  }
+
+// TREATING ANSWERS IN PARALLEL
+
+// A long run of answers is cut into chunks which are treated in parallel, each queueing its lights in a
+// buffer of its own. The buffers are then added to the feasible list in order, so that the list and the
+// lights in lts[] come out just as they would if the answers were treated one at a time.
+
+#define TCHUNK 4096 // answers per chunk
+
+struct tchunks {
+  int j,k;                      // range of answers to treat
+  int m;                        // as in getinitflist(): if >=0 the range is of alenx[]
+  struct tsink*s;               // a sink for each chunk
+  };
+
+static void tchunk(int i,void*a) {
+  struct tchunks*c;
+  struct tsink*ts;
+  int j,k;
+
+  c=(struct tchunks*)a;
+  ts=c->s+i;
+  ts->q=1;
+  k=c->j+(i+1)*TCHUNK;
+  if(k>c->k) k=c->k;
+  for(j=c->j+i*TCHUNK;j<k;j++) {
+    ts->u=treat1(ts,c->m<0?j:alenx[j]);
+    if(ts->u) return;
+    if(abort_flag) {ts->u=-5; return;}
+    }
+  }
+
+// treat answers j..k-1 (of alenx[] if m>=0) in parallel; returns as getinitflist()
+static int treatpar(int j,int k,int m) {
+  struct tchunks c;
+  struct tsink*ts;
+  char*p;
+  int a,e,i,n,u;
+
+  n=(k-j+TCHUNK-1)/TCHUNK;
+  c.j=j,c.k=k,c.m=m;
+  c.s=(struct tsink*)calloc(n,sizeof(struct tsink));
+  if(!c.s) return 1;
+  pforeach(n,filler_threads,tchunk,&c);
+  for(i=0,u=0;i<n;i++) {
+    ts=c.s+i;
+    if(!u) u=ts->u;
+    for(p=ts->b;!u&&p<ts->b+ts->n;p+=strlen(p)+1) {
+      memcpy(&a,p,sizeof(int)); p+=sizeof(int);
+      e=*p++;
+      u=addlight1(p,a,e);
+      }
+    free(ts->b);
+    }
+  free(c.s);
+  return u;
+  }
+
 // construct an initial list of feasible lights for a given length and set of light properties
 // caller's responsibility to free(*l)
 // returns !=0 on error; -5 on abort
 int getinitflist(int**l,int*ll,struct lprop*lp,int llen) {
-  int g,i,j,u;
+  int cf,g,i,j,k,m,u;
   ABM mfl[NMSG],ml[NMSG],b;
+  struct flcent*c;
 
   ntfl=0;
+  cf=0;
   curdm=lp->dmask,curem=lp->emask,curten=lp->ten;
   for(i=0;i<NMSG;i++) if(curdm&(1<<(MAXNDICTS+i))) { // "special" word for message spreading/jumble?
     DEB_FL {
@@ -600,11 +792,24 @@ int getinitflist(int**l,int*ll,struct lprop*lp,int llen) {
       printICCs(msgword[i]);
       printf(">\n");
       }
-    u=addlight(msgword[i],-1-i,0);
+    tss.a=-1-i;
+    u=addlight(&tss,msgword[i],0);
     if(u) return u;
     goto ex0;
     }
   if((curem&EM_ALL)==0) curem=EM_FWD; // force normal entry to be allowed if all are disabled
+  if(!(curten&&treatmode==TREAT_PLUGIN)) { // plug-ins may depend on where the light is in the grid, so lists from them are not cached
+    c=flcfind(llen,curdm,curem,curten?clueorderindex:-1);
+    if(c) {
+      DEB_FL printf("getinitflist(%p) llen=%d dmask=%08x emask=%08x ten=%d: %d entries from cache\n",(void*)lp,llen,curdm,curem,curten,c->n);
+      *l=malloc(c->n*sizeof(int)+1);
+      if(*l==0) return 1;
+      memcpy(*l,c->l,c->n*sizeof(int));
+      *ll=c->n;
+      return 0;
+      }
+    cf=1;
+    }
   lightlength=llen;
   DEB_FL printf("getinitflist(%p) llen=%d dmask=%08x emask=%08x ten=%d:\n",(void*)lp,llen,curdm,curem,curten);
   memset(mfl,0,sizeof(mfl));
@@ -637,12 +842,16 @@ int getinitflist(int**l,int*ll,struct lprop*lp,int llen) {
       else                    msgcharAZ09[i]='-'; // otherwise
       }
 DEB_FL { printf("  building list with msgcharICC[]="); for(i=0;i<NMSG;i++) printf("%s",icctoutf8[(int)msgcharICC[i]]); printf("\n"); }
-    for(i=0;i<atotal;i++) {
-      curans=i;
-      if((curdm&ansp[curans]->dmask)==0) continue; // not in a valid dictionary
-      if(ansp[curans]->banned) continue;
-      if(curten) u=treatans(ansp[curans]->ul);
-      else       u=treatedanswerICC(ansp[curans]->ul);
+    m=untreatedlength();
+    if(m<0) j=0,k=atotal; // look at all answers
+    else if(m>MXLE||(curdm&alendm[m])==0) j=k=0; // none of this length in a valid dictionary
+    else j=alenst[m],k=alenst[m+1]; // only those of the right length
+    if(k-j>=TCHUNK*2&&filler_threads>1&&!(curten&&treatmode==TREAT_PLUGIN)) { // plug-ins cannot be called in parallel
+      u=treatpar(j,k,m);
+      if(u) return u;
+      }
+    else for(;j<k;j++) {
+      u=treat1(&tss,m<0?j:alenx[j]);
       if(u) return u;
       if(abort_flag) return -5;
       }
@@ -655,6 +864,7 @@ DEB_FL { printf("  building list with msgcharICC[]="); for(i=0;i<NMSG;i++) print
     if(i==NMSG) break; // finish when all combinations done
     }
 ex0:
+  if(cf) flcadd(llen,curdm,curem,curten?clueorderindex:-1);
   *l=malloc(ntfl*sizeof(int)+1); // ensure we don't execute malloc(0)
   if(*l==0) return 1;
   memcpy(*l,tfl,ntfl*sizeof(int));
@@ -31,6 +31,7 @@ Fifth Floor, Boston, MA  02110-1301, USA.
 extern int getinitflist(int**l,int*ll,struct lprop*lp,int wlen);
 extern int pregetinitflist(void);
 extern int postgetinitflist(void);
+extern void invalflcache(void);
 extern char*loadtpi(void);
 extern void unloadtpi(void);
 extern void reloadtpi(void);